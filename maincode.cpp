@@ -1,6 +1,7 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <numeric>
 #include <fstream>
 #include <cstdlib>
 #include <ctime>
@@ -16,6 +17,28 @@
 #include <atomic>
 #include <unordered_map>
 #include <functional>
+#include <climits>
+#include <new>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string_view>
+#include <shared_mutex>
+#include <random>
+#include <memory>
+#ifdef _WIN32
+#include <io.h>
+#include <intrin.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BANKER_X86_SIMD 1
+#endif
 using namespace std;
 
 // ANSI escape codes for color output
@@ -28,855 +51,6374 @@ using namespace std;
 #define CYAN "\033[36m"
 #define BOLD "\033[1m"
 
-// Global configuration
-int nprocesses = 5, nresources = 4;
-vector<int> seq;
-atomic<bool> simulation_running(false);
-mutex mtx;
-condition_variable cv;
+thread_local vector<int> seq; // safe sequence of this thread's last safety check
+
+// ======================== Concurrency ========================
+// mtx guards the allocation state (processes, matrices, available):
+//  - exclusive: admission (requests, batches) and structural changes (add /
+//    remove process, deadlock recovery, config load, reset), so admission
+//    decisions are linearizable;
+//  - shared: readers (safety check, reports, deadlock detection), releases
+//    and admissions inside a resource partition (see ResourcePartitions).
+//    Releases of different processes run in parallel: each one holds the
+//    stripe lock of its process row and returns units to available with
+//    atomic adds. Partitioned admissions write the same way.
+// Readers that need a consistent view while such writes may be in flight
+// wrap their reads in ReadConsistent(), a multi-writer seqlock that retries
+// the read if any write overlapped it.
+shared_mutex mtx;
+const int kReleaseStripes = 64;
+mutex release_stripes[kReleaseStripes];
+atomic<int> releases_in_flight(0);
+atomic<uint64_t> release_epoch(0);
+
+// Other shared structures have their own locks so they never extend the
+// critical section of mtx.
+mutex history_mtx; // history, historical_need
+mutex chain_mtx;   // blockchain window, chain_length, ledger append order
+
+void AtomicAdd(int& target, int value) {
+#ifdef _MSC_VER
+    _InterlockedExchangeAdd(reinterpret_cast<volatile long*>(&target), value);
+#else
+    __atomic_fetch_add(&target, value, __ATOMIC_RELAXED);
+#endif
+}
 
-// Resource allocation history tracking
-struct AllocationHistory {
-    int pid;
-    vector<int> resources;
-    time_t timestamp;
-    string action; // e.g., "allocate", "release"
-};
+int AtomicLoad(const int& source) {
+#ifdef _MSC_VER
+    return static_cast<int>(_InterlockedOr(reinterpret_cast<volatile long*>(const_cast<int*>(&source)), 0));
+#else
+    return __atomic_load_n(&source, __ATOMIC_RELAXED);
+#endif
+}
 
-vector<AllocationHistory> history;
-unordered_map<int, vector<vector<int>>> historical_need;
+// Bracket the writes of a release (or a partitioned admission) so
+// concurrent readers can detect them
+void BeginRelease() { releases_in_flight.fetch_add(1); }
+void EndRelease() {
+    release_epoch.fetch_add(1);
+    releases_in_flight.fetch_sub(1);
+}
 
-// Enhanced process structure
-typedef struct {
-    int id;
-    vector<int> Max;
-    vector<int> Allocation;
-    vector<int> Need;
-    bool status; // true if completed, false if active
-    int priority;
-    time_t start_time;
-    time_t end_time;
-    vector<int> request_history;
-    double cpu_usage; // Simulated CPU usage
-    int wait_time; // Time spent waiting for resources
-} process;
+// Run read() until it completes without overlapping any release. The caller
+// must hold mtx (shared); read() must only fill in locals.
+template <typename F>
+void ReadConsistent(F read) {
+    while (true) {
+        uint64_t epoch = release_epoch.load();
+        if (releases_in_flight.load() == 0) {
+            read();
+            if (releases_in_flight.load() == 0 && release_epoch.load() == epoch) return;
+        }
+        this_thread::yield();
+    }
+}
 
-vector<process> processes;
-vector<int> available;
-vector<int> total_resources;
-vector<int> historical_available;
+// ======================== Latency Histograms ========================
+// Log-linear histograms in the style of HdrHistogram. Values below 128 ns
+// get a bucket each; above that every power of two is split into 64 buckets,
+// so a reported percentile is within 1.6% of the recorded value. Each thread
+// records into its own slot with uncontended atomic adds; readers merge the
+// slots when they summarize.
+enum class LatencyOp { Request, Release, SafetyCheck, BlockAppend, LogWrite };
+const int kLatencyOps = 5;
+
+const char* LatencyOpName(LatencyOp op) {
+    switch (op) {
+        case LatencyOp::Request: return "Request";
+        case LatencyOp::Release: return "Release";
+        case LatencyOp::SafetyCheck: return "Safety check";
+        case LatencyOp::BlockAppend: return "Block append";
+        case LatencyOp::LogWrite: return "Log write";
+    }
+    return "?";
+}
 
-// Blockchain-like security structure
-struct Block {
-    int index;
-    time_t timestamp;
-    string transaction;
-    string previous_hash;
-    string hash;
-};
+const int kLatencySubBits = 7;
+const int kLatencySubCount = 1 << kLatencySubBits;
+const int kLatencyHalfCount = kLatencySubCount / 2;
+const int kLatencyMaxShift = 40 - kLatencySubBits + 1; // covers up to ~2^40 ns
+const int kLatencyBuckets = kLatencySubCount + kLatencyMaxShift * kLatencyHalfCount;
+
+int HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
 
-vector<Block> blockchain;
+int LatencyBucket(uint64_t ns) {
+    if (ns < static_cast<uint64_t>(kLatencySubCount)) return static_cast<int>(ns);
+    int shift = HighestBit(ns) - (kLatencySubBits - 1);
+    if (shift > kLatencyMaxShift) return kLatencyBuckets - 1;
+    return shift * kLatencyHalfCount + static_cast<int>(ns >> shift);
+}
 
-// Simulation statistics
-struct SimulationStats {
-    int requests_processed;
-    int deadlocks_detected;
-    int deadlocks_resolved;
-    double avg_response_time;
-    int total_cycles;
+// Highest value that lands in the bucket
+uint64_t LatencyBucketLimit(int bucket) {
+    if (bucket < kLatencySubCount) return bucket;
+    int shift = bucket / kLatencyHalfCount - 1;
+    uint64_t sub = bucket - shift * kLatencyHalfCount;
+    return ((sub + 1) << shift) - 1;
+}
+
+struct LatencySummary {
+    uint64_t count;
+    double mean_ns;
+    uint64_t p50, p90, p99, p999, max;
 };
 
-SimulationStats sim_stats = {0, 0, 0, 0.0, 0};
+// Single-threaded histogram; also the merge target of LatencyRecorder
+struct LatencyHistogram {
+    vector<uint64_t> counts;
+    uint64_t sum_ns;
+    uint64_t max_ns;
 
-// Logging function
-void LogAction(const string& action, const string& details) {
-    ofstream log("system.log", ios::app);
-    time_t now = time(nullptr);
-    log << ctime(&now) << action << ": " << details << endl;
-    log.close();
-}
+    LatencyHistogram() : counts(kLatencyBuckets, 0), sum_ns(0), max_ns(0) {}
 
-// Function prototypes
-void InitializeBlockchain();
-string CalculateHash(const Block& block);
-void AddBlock(const string& transaction);
-void VisualizeResourceGraph();
-void PredictiveAllocation();
-void HandleDeadlock();
-void SimulationWorker();
-void StartSimulation();
-void StopSimulation();
-void SaveStateToFile(const string& filename);
-void LoadStateFromFile(const string& filename);
-void NetworkSync();
-void PerformanceMetrics();
-void GenerateSecurityReport();
-void DisplayResourceUtilizationTrends();
-void DisplayBlockchain();
-void AddProcess(int max_resources, int priority);
-void RemoveProcess(int pid);
-void RequestResources(int pid, const vector<int>& request);
-void ReleaseResources(int pid, const vector<int>& release);
-void DetectDeadlockCycle();
-void ExportToText();
-void DisplayProcessStatus();
-void LoadConfigFromText(const string& filename);
-void DisplaySimulationStats();
-void UpdatePriorityQueue();
-void DisplayPriorityQueue();
-void ValidateInput(int pid, const vector<int>& vec, const string& type);
-void InitializeSystem();
+    void Record(uint64_t ns) {
+        counts[LatencyBucket(ns)]++;
+        sum_ns += ns;
+        max_ns = max(max_ns, ns);
+    }
 
-// ======================== Core Banker's Algorithm Functions ========================
+    LatencySummary Summarize() const {
+        LatencySummary summary = {};
+        for (uint64_t c : counts) summary.count += c;
+        summary.max = max_ns;
+        if (summary.count == 0) return summary;
+        summary.mean_ns = static_cast<double>(sum_ns) / summary.count;
+
+        const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+        uint64_t* targets[] = {&summary.p50, &summary.p90, &summary.p99, &summary.p999};
+        uint64_t seen = 0;
+        int q = 0;
+        for (int b = 0; b < kLatencyBuckets && q < 4; b++) {
+            seen += counts[b];
+            while (q < 4 && seen >= static_cast<uint64_t>(ceil(quantiles[q] * summary.count))) {
+                *targets[q++] = min(LatencyBucketLimit(b), max_ns);
+            }
+        }
+        return summary;
+    }
+};
 
-void DisplayAllocationTable(const vector<process>& processes) {
-    cout << "\n\t" << BOLD << "Allocation Table" << RESET;
-    cout << "\nProcess\t";
-    for (int i = 0; i < nresources; i++) {
-        cout << "R" << i << "\t";
+class LatencyRecorder {
+public:
+    void Record(LatencyOp op, uint64_t ns) {
+        Slot& slot = LocalSlot();
+        int o = static_cast<int>(op);
+        slot.counts[o][LatencyBucket(ns)].fetch_add(1, memory_order_relaxed);
+        slot.sum_ns[o].fetch_add(ns, memory_order_relaxed);
+        if (ns > slot.max_ns[o].load(memory_order_relaxed)) slot.max_ns[o].store(ns, memory_order_relaxed);
     }
-    cout << "Priority\tStatus";
-    cout << endl;
 
-    for (int i = 0; i < nprocesses; i++) {
-        cout << "P" << i << "\t";
-        for (int j = 0; j < nresources; j++) {
-            cout << processes[i].Allocation[j] << "\t";
+    LatencySummary Summarize(LatencyOp op) {
+        int o = static_cast<int>(op);
+        LatencyHistogram merged;
+        lock_guard<mutex> lock(registry_mtx_);
+        for (const auto& slot : slots_) {
+            for (int b = 0; b < kLatencyBuckets; b++) {
+                merged.counts[b] += slot->counts[o][b].load(memory_order_relaxed);
+            }
+            merged.sum_ns += slot->sum_ns[o].load(memory_order_relaxed);
+            merged.max_ns = max(merged.max_ns, slot->max_ns[o].load(memory_order_relaxed));
         }
-        cout << processes[i].priority << "\t" << (processes[i].status ? "Done" : "Active");
-        cout << endl;
+        return merged.Summarize();
     }
-    LogAction("Display", "Allocation table displayed");
-}
 
-bool IsSafe(vector<process> processes, vector<int> available) {
-    vector<int> work = available;
-    vector<bool> finish(nprocesses, false);
-    seq.clear();
+    // Increments that race with a reset may survive it
+    void Reset() {
+        lock_guard<mutex> lock(registry_mtx_);
+        for (auto& slot : slots_) slot->Clear();
+    }
 
-    while (true) {
-        bool found = false;
-        for (int i = 0; i < nprocesses; i++) {
-            if (!finish[i] && !processes[i].status) {
-                bool can_allocate = true;
-                for (int j = 0; j < nresources; j++) {
-                    if (processes[i].Need[j] > work[j]) {
-                        can_allocate = false;
-                        break;
-                    }
-                }
-                if (can_allocate) {
-                    for (int j = 0; j < nresources; j++) {
-                        work[j] += processes[i].Allocation[j];
-                    }
-                    finish[i] = true;
-                    seq.push_back(i);
-                    found = true;
-
-                    // Record history
-                    AllocationHistory h;
-                    h.pid = i;
-                    h.resources = processes[i].Allocation;
-                    h.timestamp = time(nullptr);
-                    h.action = "allocate";
-                    history.push_back(h);
+private:
+    struct Slot {
+        atomic<uint64_t> counts[kLatencyOps][kLatencyBuckets];
+        atomic<uint64_t> sum_ns[kLatencyOps];
+        atomic<uint64_t> max_ns[kLatencyOps];
+        bool in_use;
+
+        void Clear() {
+            for (int o = 0; o < kLatencyOps; o++) {
+                for (int b = 0; b < kLatencyBuckets; b++) counts[o][b].store(0, memory_order_relaxed);
+                sum_ns[o].store(0, memory_order_relaxed);
+                max_ns[o].store(0, memory_order_relaxed);
+            }
+        }
+    };
+
+    // Claims a slot for the calling thread and hands it back when the thread
+    // exits; the counts stay in the slot for the next thread that claims it.
+    struct SlotLease {
+        LatencyRecorder* owner;
+        Slot* slot;
+
+        explicit SlotLease(LatencyRecorder* recorder) : owner(recorder), slot(nullptr) {
+            lock_guard<mutex> lock(owner->registry_mtx_);
+            for (auto& candidate : owner->slots_) {
+                if (!candidate->in_use) {
+                    slot = candidate.get();
+                    break;
                 }
             }
+            if (!slot) {
+                owner->slots_.emplace_back(new Slot());
+                slot = owner->slots_.back().get();
+                slot->Clear();
+            }
+            slot->in_use = true;
         }
-        if (!found) break;
-    }
 
-    for (int i = 0; i < nprocesses; i++) {
-        if (!finish[i] && !processes[i].status) return false;
+        ~SlotLease() {
+            lock_guard<mutex> lock(owner->registry_mtx_);
+            slot->in_use = false;
+        }
+    };
+
+    Slot& LocalSlot() {
+        thread_local SlotLease lease(this);
+        return *lease.slot;
     }
-    return true;
-}
 
-// ======================== Enhanced Features ========================
+    mutex registry_mtx_;
+    vector<unique_ptr<Slot>> slots_;
+};
 
-void InitializeBlockchain() {
-    Block genesis;
-    genesis.index = 0;
-    genesis.timestamp = time(nullptr);
-    genesis.transaction = "Genesis Block";
-    genesis.previous_hash = "0";
-    genesis.hash = CalculateHash(genesis);
-    blockchain.push_back(genesis);
-    LogAction("Blockchain", "Initialized with genesis block");
-}
+LatencyRecorder latency;
 
-string CalculateHash(const Block& block) {
-    stringstream ss;
-    ss << block.index << block.timestamp << block.transaction << block.previous_hash;
-    string input = ss.str();
+// Records the lifetime of the object as one sample of op
+class ScopedLatency {
+public:
+    explicit ScopedLatency(LatencyOp op) : op_(op), start_(chrono::steady_clock::now()) {}
+    ~ScopedLatency() {
+        auto ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start_).count();
+        latency.Record(op_, static_cast<uint64_t>(ns));
+    }
 
-    // Simple hash function (FNV-1a)
-    const uint64_t FNV_PRIME = 16777619;
-    const uint64_t FNV_OFFSET = 2166136261;
-    uint64_t hash = FNV_OFFSET;
+private:
+    LatencyOp op_;
+    chrono::steady_clock::time_point start_;
+};
 
-    for (char c : input) {
-        hash ^= static_cast<uint64_t>(c);
-        hash *= FNV_PRIME;
+void PrintLatencyTable() {
+    cout << "Latency (μs)  " << right << setw(10) << "count" << setw(10) << "mean"
+         << setw(10) << "p50" << setw(10) << "p90" << setw(10) << "p99" << setw(10) << "p99.9"
+         << setw(10) << "max" << endl;
+    cout << fixed << setprecision(2);
+    for (int o = 0; o < kLatencyOps; o++) {
+        LatencyOp op = static_cast<LatencyOp>(o);
+        LatencySummary s = latency.Summarize(op);
+        cout << left << setw(14) << LatencyOpName(op) << right << setw(10) << s.count
+             << setw(10) << s.mean_ns / 1000 << setw(10) << s.p50 / 1000.0 << setw(10) << s.p90 / 1000.0
+             << setw(10) << s.p99 / 1000.0 << setw(10) << s.p999 / 1000.0 << setw(10) << s.max / 1000.0 << endl;
     }
-
-    stringstream hash_ss;
-    hash_ss << hex << setw(16) << setfill('0') << hash;
-    return hash_ss.str();
 }
 
-void AddBlock(const string& transaction) {
-    Block newBlock;
-    newBlock.index = blockchain.size();
-    newBlock.timestamp = time(nullptr);
-    newBlock.transaction = transaction;
-    newBlock.previous_hash = blockchain.back().hash;
-    newBlock.hash = CalculateHash(newBlock);
-    blockchain.push_back(newBlock);
+// Resource allocation history tracking. Entries live in a fixed-capacity
+// ring, so a long run holds at most capacity entries: once the ring is full
+// each append evicts the oldest one. An entry is a pid, an action, a
+// timestamp and one inline row of resource amounts; the rows of all entries
+// share a single buffer of capacity * width ints. Evicted entries can be
+// spilled to a binary file instead of being dropped:
+//   8-byte magic, then per entry i64 timestamp | i32 pid | u32 width | u8 action | width i32
+// The owner serializes access (history_mtx for the globals).
+enum class HistoryAction : uint8_t { Allocate, Release, Need };
+
+const char* HistoryActionName(HistoryAction action) {
+    switch (action) {
+        case HistoryAction::Allocate: return "allocate";
+        case HistoryAction::Release: return "release";
+        case HistoryAction::Need: return "need";
+    }
+    return "?";
+}
 
-    // Log to file
-    ofstream log("blockchain.log", ios::app);
-    log << "Block #" << newBlock.index << " | " << ctime(&newBlock.timestamp);
-    log << "Transaction: " << transaction << endl;
-    log << "Hash: " << newBlock.hash << endl << endl;
-    log.close();
-    LogAction("Blockchain", "Added block with transaction: " + transaction);
+bool ParseHistoryAction(const string& name, HistoryAction& action) {
+    for (HistoryAction a : {HistoryAction::Allocate, HistoryAction::Release, HistoryAction::Need}) {
+        if (name == HistoryActionName(a)) {
+            action = a;
+            return true;
+        }
+    }
+    return false;
 }
 
-void VisualizeResourceGraph() {
-    cout << "\n" << BOLD << CYAN << "Resource Allocation Graph:" << RESET << endl;
-    cout << "Processes: ";
-    for (int i = 0; i < nprocesses; i++) {
-        cout << "P" << i << " ";
+// View of one entry, valid until the next append to its ring
+struct AllocationHistory {
+    int pid;
+    HistoryAction action;
+    time_t timestamp;
+    const int* resources;
+};
+
+class HistoryRing {
+public:
+    static const size_t kDefaultCapacity = 4096;
+    static const size_t kMaxCapacity = size_t(1) << 24;  // entries; bounds configured and loaded capacities
+    static const char kSpillMagic[9];
+
+    explicit HistoryRing(size_t capacity = kDefaultCapacity) : capacity_(max<size_t>(capacity, 1)) { Allocate(); }
+    HistoryRing(const HistoryRing&) = delete;
+    HistoryRing& operator=(const HistoryRing&) = delete;
+    ~HistoryRing() { SetSpill(""); }
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    int width() const { return width_; }
+    uint64_t Spilled() const { return spilled_; }
+    const string& SpillPath() const { return spill_path_; }
+
+    // Bytes held by the entries, independent of how many were appended
+    size_t MemoryBytes() const {
+        return pids_.capacity() * sizeof(int32_t) + times_.capacity() * sizeof(int64_t) +
+               actions_.capacity() + rows_.capacity() * sizeof(int);
     }
-    cout << "\nResources: ";
-    for (int i = 0; i < nresources; i++) {
-        cout << "R" << i << "(" << available[i] << ") ";
+
+    // Oldest retained entry first
+    AllocationHistory operator[](size_t i) const {
+        size_t slot = Slot(i);
+        return {pids_[slot], static_cast<HistoryAction>(actions_[slot]), static_cast<time_t>(times_[slot]),
+                rows_.data() + slot * width_};
     }
-    cout << "\n\nAllocations:\n";
 
-    for (int i = 0; i < nprocesses; i++) {
-        cout << "P" << i << " -> ";
-        for (int j = 0; j < nresources; j++) {
-            if (processes[i].Allocation[j] > 0) {
-                cout << "R" << j << "(" << processes[i].Allocation[j] << ") ";
-            }
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+
+    // Drop all entries and set the row width (the number of resources)
+    void Reset(int width) {
+        clear();
+        width_ = width;
+        rows_.assign(capacity_ * width_, 0);
+    }
+
+    // Keeps the newest min(size, capacity) entries
+    void SetCapacity(size_t capacity) {
+        capacity = max<size_t>(capacity, 1);
+        size_t keep = min(size_, capacity);
+        vector<int32_t> pids(capacity);
+        vector<int64_t> times(capacity);
+        vector<uint8_t> actions(capacity);
+        vector<int> rows(capacity * width_);
+        for (size_t k = 0; k < keep; k++) {
+            size_t slot = Slot(size_ - keep + k);
+            pids[k] = pids_[slot];
+            times[k] = times_[slot];
+            actions[k] = actions_[slot];
+            copy(rows_.begin() + slot * width_, rows_.begin() + (slot + 1) * width_, rows.begin() + k * width_);
         }
-        cout << endl;
+        pids_.swap(pids);
+        times_.swap(times);
+        actions_.swap(actions);
+        rows_.swap(rows);
+        capacity_ = capacity;
+        size_ = keep;
+        head_ = keep % capacity_;
     }
 
-    cout << "\nRequests:\n";
-    for (int i = 0; i < nprocesses; i++) {
-        cout << "P" << i << " needs: ";
-        for (int j = 0; j < nresources; j++) {
-            if (processes[i].Need[j] > 0) {
-                cout << "R" << j << "(" << processes[i].Need[j] << ") ";
-            }
+    // Spill evicted entries to path; an empty path stops spilling
+    bool SetSpill(const string& path) {
+        if (spill_) {
+            FlushSpill();
+            fclose(spill_);
+            spill_ = nullptr;
         }
-        cout << endl;
+        spill_path_.clear();
+        if (path.empty()) return true;
+        spill_ = fopen(path.c_str(), "ab");
+        if (!spill_) return false;
+        if (ftell(spill_) == 0) fwrite(kSpillMagic, 1, 8, spill_);
+        spill_path_ = path;
+        return true;
     }
 
-    // Detect potential deadlocks visually
-    bool potential_deadlock = false;
-    for (int i = 0; i < nprocesses; i++) {
-        for (int j = 0; j < nresources; j++) {
-            if (processes[i].Need[j] > available[j]) {
-                cout << RED << "! P" << i << " is waiting for R" << j << RESET << endl;
-                potential_deadlock = true;
-            }
+    // A row of a different width than the ring's restarts it at that width
+    void Append(int pid, HistoryAction action, const vector<int>& amounts, time_t timestamp = time(nullptr)) {
+        if (static_cast<int>(amounts.size()) != width_) Reset(static_cast<int>(amounts.size()));
+        if (size_ == capacity_) {
+            if (spill_) Spill(head_);
+        } else {
+            size_++;
         }
+        pids_[head_] = pid;
+        times_[head_] = timestamp;
+        actions_[head_] = static_cast<uint8_t>(action);
+        copy(amounts.begin(), amounts.end(), rows_.begin() + head_ * width_);
+        if (++head_ == capacity_) head_ = 0;
     }
 
-    if (potential_deadlock) {
-        cout << YELLOW << "\nWarning: Potential deadlock detected!" << RESET << endl;
-        sim_stats.deadlocks_detected++;
-    } else {
-        cout << GREEN << "\nNo immediate deadlock detected" << RESET << endl;
+private:
+    static const size_t kSpillFlushBytes = 64 * 1024;
+
+    void Allocate() {
+        pids_.assign(capacity_, 0);
+        times_.assign(capacity_, 0);
+        actions_.assign(capacity_, 0);
+        rows_.assign(capacity_ * width_, 0);
     }
-    LogAction("Graph", "Resource allocation graph displayed");
-}
 
-void PredictiveAllocation() {
-    cout << "\n" << BOLD << MAGENTA << "Predictive Resource Allocation:" << RESET << endl;
+    size_t Slot(size_t i) const {
+        size_t slot = head_ + capacity_ - size_ + i;
+        return slot >= capacity_ ? slot - capacity_ : slot;
+    }
 
-    if (history.size() < 10) {
-        cout << "Insufficient data for prediction (need at least 10 history records)" << endl;
-        return;
+    template <typename T>
+    void Put(T value) {
+        spill_buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
     }
 
-    vector<double> avg_increase(nresources, 0.0);
-    for (int j = 0; j < nresources; j++) {
-        double sum = 0;
-        int count = 0;
-        for (size_t i = 1; i < history.size(); i++) {
-            int diff = history[i].resources[j] - history[i-1].resources[j];
-            if (diff > 0) {
-                sum += diff;
-                count++;
+    void Spill(size_t slot) {
+        Put<int64_t>(times_[slot]);
+        Put<int32_t>(pids_[slot]);
+        Put<uint32_t>(static_cast<uint32_t>(width_));
+        Put<uint8_t>(actions_[slot]);
+        spill_buffer_.append(reinterpret_cast<const char*>(rows_.data() + slot * width_), width_ * sizeof(int));
+        spilled_++;
+        if (spill_buffer_.size() >= kSpillFlushBytes) FlushSpill();
+    }
+
+    void FlushSpill() {
+        if (!spill_buffer_.empty()) fwrite(spill_buffer_.data(), 1, spill_buffer_.size(), spill_);
+        spill_buffer_.clear();
+        fflush(spill_);
+    }
+
+    vector<int32_t> pids_;
+    vector<int64_t> times_;
+    vector<uint8_t> actions_;
+    vector<int> rows_;
+    size_t head_ = 0;  // slot of the next append
+    size_t size_ = 0;
+    size_t capacity_;
+    int width_ = 0;
+    FILE* spill_ = nullptr;
+    string spill_path_;
+    string spill_buffer_;
+    uint64_t spilled_ = 0;
+};
+
+const char HistoryRing::kSpillMagic[9] = "BHIST001";
+
+// Streaming statistics over the allocation history, updated as entries are
+// appended so the reports answer in O(nresources) however long the history
+// is. Per resource it keeps
+//  - the rate of increase: the mean and an EWMA of the positive steps
+//    between consecutive entries, since the last reset (evicted entries
+//    still count);
+//  - a sliding window over the last window() amounts with a running sum and
+//    sum of squares, for the windowed mean and variance.
+// Sums are kept in integers, so the window never drifts. The owner
+// serializes access (history_mtx for the globals).
+class HistoryStats {
+public:
+    static const int kDefaultWindow = 5;
+    static constexpr double kDefaultAlpha = 0.2;
+
+    uint64_t Observed() const { return observed_; }
+    int Window() const { return window_; }
+    int WindowFill() const { return fill_; }
+    double Alpha() const { return alpha_; }
+
+    void Reset(int width) {
+        width_ = width;
+        observed_ = 0;
+        last_.assign(width_, 0);
+        increase_sum_.assign(width_, 0);
+        increase_count_.assign(width_, 0);
+        ewma_.assign(width_, 0.0);
+        ClearWindow();
+    }
+
+    // A row of a different width restarts the statistics at that width
+    void Observe(const int* amounts, int width) {
+        if (width != width_) Reset(width);
+        for (int j = 0; j < width_; j++) {
+            if (observed_ > 0 && amounts[j] > last_[j]) {
+                int step = amounts[j] - last_[j];
+                increase_sum_[j] += step;
+                ewma_[j] = increase_count_[j]++ == 0 ? step : alpha_ * step + (1 - alpha_) * ewma_[j];
             }
+            last_[j] = amounts[j];
         }
-        avg_increase[j] = (count > 0) ? sum / count : 0;
+        observed_++;
+        Slide(amounts);
     }
 
-    cout << "Predicted resource requests in next cycle:\n";
-    for (int j = 0; j < nresources; j++) {
-        cout << "R" << j << ": " << fixed << setprecision(2) << avg_increase[j] << "\t";
+    // Resize the window and refill it from the newest entries of ring
+    void SetWindow(int window, const HistoryRing& ring) {
+        window_ = max(window, 1);
+        ClearWindow();
+        if (ring.width() != width_) return;
+        size_t n = min(ring.size(), static_cast<size_t>(window_));
+        for (size_t i = ring.size() - n; i < ring.size(); i++) Slide(ring[i].resources);
     }
-    cout << endl;
 
-    cout << "\nAllocation strategy suggestion:\n";
-    for (int j = 0; j < nresources; j++) {
-        if (avg_increase[j] > available[j]) {
-            cout << RED << "Warning: R" << j << " may be insufficient (Need: " 
-                 << avg_increase[j] << ", Available: " << available[j] << ")" << RESET << endl;
-        } else if (avg_increase[j] > available[j] * 0.7) {
-            cout << YELLOW << "Monitor R" << j << " closely (Need: " 
-                 << avg_increase[j] << ", Available: " << available[j] << ")" << RESET << endl;
-        } else {
-            cout << GREEN << "R" << j << " is sufficient (Need: " 
-                 << avg_increase[j] << ", Available: " << available[j] << ")" << RESET << endl;
-        }
+    // Applies to steps observed from now on
+    void SetAlpha(double alpha) { alpha_ = alpha; }
+
+    double IncreaseMean(int j) const {
+        return increase_count_[j] > 0 ? static_cast<double>(increase_sum_[j]) / increase_count_[j] : 0.0;
     }
-    LogAction("Prediction", "Predictive allocation analyzed");
-}
 
-void HandleDeadlock() {
-    cout << "\n" << BOLD << RED << "Deadlock Handling Mechanism" << RESET << endl;
+    double IncreaseEwma(int j) const { return ewma_[j]; }
 
-    int lowest_priority = INT_MAX;
-    int victim = -1;
+    double WindowMean(int j) const { return fill_ > 0 ? static_cast<double>(window_sum_[j]) / fill_ : 0.0; }
 
-    for (int i = 0; i < nprocesses; i++) {
-        if (!processes[i].status && processes[i].priority < lowest_priority) {
-            lowest_priority = processes[i].priority;
-            victim = i;
-        }
+    double WindowVariance(int j) const {
+        if (fill_ == 0) return 0.0;
+        double mean = WindowMean(j);
+        return max(0.0, static_cast<double>(window_sum_sq_[j]) / fill_ - mean * mean);
     }
 
-    if (victim == -1) {
-        cout << "No suitable victim found" << endl;
-        return;
+private:
+    void ClearWindow() {
+        window_rows_.assign(static_cast<size_t>(window_) * width_, 0);
+        window_sum_.assign(width_, 0);
+        window_sum_sq_.assign(width_, 0);
+        next_ = 0;
+        fill_ = 0;
     }
 
-    cout << "Terminating process P" << victim << " (priority: " 
-         << processes[victim].priority << ") to resolve deadlock" << endl;
+    void Slide(const int* amounts) {
+        int* slot = window_rows_.data() + static_cast<size_t>(next_) * width_;
+        for (int j = 0; j < width_; j++) {
+            if (fill_ == window_) {
+                window_sum_[j] -= slot[j];
+                window_sum_sq_[j] -= static_cast<int64_t>(slot[j]) * slot[j];
+            }
+            slot[j] = amounts[j];
+            window_sum_[j] += amounts[j];
+            window_sum_sq_[j] += static_cast<int64_t>(amounts[j]) * amounts[j];
+        }
+        if (fill_ < window_) fill_++;
+        if (++next_ == window_) next_ = 0;
+    }
 
-    for (int j = 0; j < nresources; j++) {
-        available[j] += processes[victim].Allocation[j];
-        processes[victim].Allocation[j] = 0;
-        processes[victim].Need[j] = 0;
+    int width_ = 0;
+    int window_ = kDefaultWindow;
+    double alpha_ = kDefaultAlpha;
+    uint64_t observed_ = 0;
+    vector<int> last_;
+    vector<int64_t> increase_sum_;
+    vector<int64_t> increase_count_;
+    vector<double> ewma_;
+    vector<int> window_rows_;  // window_ rows of width_, oldest at next_ once full
+    vector<int64_t> window_sum_;
+    vector<int64_t> window_sum_sq_;
+    int next_ = 0;
+    int fill_ = 0;
+};
+
+// Allocator handing out storage aligned to Align bytes (e.g. a cache line)
+template <typename T, size_t Align>
+struct AlignedAllocator {
+    typedef T value_type;
+    template <typename U> struct rebind { typedef AlignedAllocator<U, Align> other; };
+
+    AlignedAllocator() {}
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Align>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), align_val_t(Align)));
     }
-    processes[victim].status = true;
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, align_val_t(Align));
+    }
+    template <typename U> bool operator==(const AlignedAllocator<U, Align>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Align>&) const { return false; }
+};
 
-    string transaction = "Deadlock resolution: Terminated P" + to_string(victim);
-    AddBlock(transaction);
-    sim_stats.deadlocks_resolved++;
-    cout << "Resources released. System should now be deadlock-free." << endl;
-    LogAction("Deadlock", "Resolved by terminating P" + to_string(victim));
-}
+// Ints per 256-bit SIMD register; matrix rows are padded to a multiple of this
+const int kResourceLanes = 8;
 
-void SimulationWorker() {
-    while (simulation_running) {
-        {
-            lock_guard<mutex> lock(mtx);
-            auto start = chrono::high_resolution_clock::now();
+// Contiguous row-major process x resource matrix. Every row is padded with
+// zeros to a multiple of kResourceLanes and the storage is cache-line aligned,
+// so row scans never straddle another process's data and can always be
+// processed a full vector register at a time.
+class ResourceMatrix {
+public:
+    ResourceMatrix() : rows_(0), cols_(0), stride_(0) {}
 
-            int p = rand() % nprocesses;
-            vector<int> req(nresources, 0);
+    static int PaddedWidth(int cols) {
+        return (cols + kResourceLanes - 1) / kResourceLanes * kResourceLanes;
+    }
 
-            for (int j = 0; j < nresources; j++) {
-                if (processes[p].Need[j] > 0) {
-                    req[j] = rand() % min(processes[p].Need[j] + 1, available[j] + 1);
-                }
-            }
+    // Resize to rows x cols, zero-filled
+    void Reset(int rows, int cols) {
+        rows_ = rows;
+        cols_ = cols;
+        stride_ = PaddedWidth(cols);
+        data_.assign(static_cast<size_t>(rows) * stride_, 0);
+    }
 
-            cout << CYAN << "\nSimulation: P" << p << " requests [";
-            for (int r : req) cout << r << " ";
-            cout << "]" << RESET << endl;
+    // Append a row with every column set to value
+    void AppendRow(int value) {
+        data_.resize(data_.size() + stride_, 0);
+        fill(Row(rows_), Row(rows_) + cols_, value);
+        rows_++;
+    }
 
-            bool granted = true;
-            for (int j = 0; j < nresources; j++) {
-                if (req[j] > available[j]) {
-                    granted = false;
-                    break;
-                }
-            }
+    // Append a row copied from values (extra values are ignored, missing ones are 0)
+    void AppendRow(const vector<int>& values) {
+        data_.resize(data_.size() + stride_, 0);
+        copy(values.begin(), values.begin() + min<size_t>(values.size(), cols_), Row(rows_));
+        rows_++;
+    }
 
-            if (granted) {
-                for (int j = 0; j < nresources; j++) {
-                    available[j] -= req[j];
-                    processes[p].Allocation[j] += req[j];
-                    processes[p].Need[j] -= req[j];
-                }
+    int* Row(int i) { return data_.data() + static_cast<size_t>(i) * stride_; }
+    const int* Row(int i) const { return data_.data() + static_cast<size_t>(i) * stride_; }
+    int& operator()(int i, int j) { return Row(i)[j]; }
+    int operator()(int i, int j) const { return Row(i)[j]; }
 
-                if (IsSafe(processes, available)) {
-                    cout << GREEN << "Request granted. System safe." << RESET << endl;
-                    string transaction = "P" + to_string(p) + " allocated resources";
-                    AddBlock(transaction);
-                } else {
-                    cout << RED << "Request granted but led to unsafe state. Rolling back." << RESET << endl;
-                    for (int j = 0; j < nresources; j++) {
-                        available[j] += req[j];
-                        processes[p].Allocation[j] -= req[j];
-                        processes[p].Need[j] += req[j];
-                    }
-                }
-            } else {
-                cout << YELLOW << "Request denied. Insufficient resources." << RESET << endl;
-                processes[p].wait_time += 1;
-            }
+    vector<int> RowVector(int i) const { return vector<int>(Row(i), Row(i) + cols_); }
 
-            historical_need[p].push_back(processes[p].Need);
-            sim_stats.requests_processed++;
-            auto end = chrono::high_resolution_clock::now();
-            auto duration = chrono::duration_cast<chrono::microseconds>(end - start).count();
-            sim_stats.avg_response_time = (sim_stats.avg_response_time * (sim_stats.requests_processed - 1) + duration) / sim_stats.requests_processed;
-            sim_stats.total_cycles++;
-        }
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+    int stride() const { return stride_; }
+
+private:
+    int rows_, cols_, stride_;
+    vector<int, AlignedAllocator<int, 64>> data_;
+};
 
-        this_thread::sleep_for(chrono::seconds(1 + rand() % 3));
+// Per-resource sums over the first rows of a matrix, accumulated row by row
+// so the scan walks memory sequentially.
+vector<int> ColumnTotals(const ResourceMatrix& m, int rows) {
+    vector<int> totals(m.stride(), 0);
+    for (int i = 0; i < rows; i++) {
+        const int* row = m.Row(i);
+        for (int j = 0; j < m.stride(); j++) totals[j] += row[j];
     }
+    totals.resize(m.cols());
+    return totals;
 }
 
-void StartSimulation() {
-    if (simulation_running) {
-        cout << "Simulation already running" << endl;
-        return;
-    }
+// ======================== Row Kernels ========================
+// Vector comparisons between resource rows (Need vs Work, request vs
+// available, ...). An AVX2 or SSE4.1 implementation is picked at startup
+// based on the running CPU, with a portable scalar fallback.
 
-    simulation_running = true;
-    thread worker(SimulationWorker);
-    worker.detach();
-    cout << GREEN << "Simulation started" << RESET << endl;
-    LogAction("Simulation", "Started");
+struct RowKernels {
+    const char* name;
+    bool (*fits)(const int* a, const int* b, int n);           // every a[j] <= b[j]
+    int (*count_greater)(const int* a, const int* b, int n);   // number of a[j] > b[j]
+    void (*add)(int* dst, const int* src, int n);               // dst[j] += src[j]
+};
+
+bool FitsScalar(const int* a, const int* b, int n) {
+    for (int j = 0; j < n; j++) {
+        if (a[j] > b[j]) return false;
+    }
+    return true;
 }
 
-void StopSimulation() {
-    simulation_running = false;
-    cout << RED << "Simulation stopped" << RESET << endl;
-    LogAction("Simulation", "Stopped");
+int CountGreaterScalar(const int* a, const int* b, int n) {
+    int count = 0;
+    for (int j = 0; j < n; j++) count += a[j] > b[j];
+    return count;
 }
 
-void DisplayResourceUtilizationTrends() {
-    cout << "\n" << BOLD << BLUE << "Resource Utilization Trends:" << RESET << endl;
+void AddScalar(int* dst, const int* src, int n) {
+    for (int j = 0; j < n; j++) dst[j] += src[j];
+}
 
-    if (history.size() < 5) {
-        cout << "Insufficient history data for trend analysis (need at least 5 records)" << endl;
-        return;
+#ifdef BANKER_X86_SIMD
+__attribute__((target("avx2"))) bool FitsAvx2(const int* a, const int* b, int n) {
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i gt = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(a + j)),
+                                        _mm256_loadu_si256((const __m256i*)(b + j)));
+        if (!_mm256_testz_si256(gt, gt)) return false;
     }
+    return FitsScalar(a + j, b + j, n - j);
+}
 
-    vector<double> avg_utilization(nresources, 0.0);
-    int cycles = min(5, static_cast<int>(history.size()));
+__attribute__((target("avx2,popcnt"))) int CountGreaterAvx2(const int* a, const int* b, int n) {
+    int count = 0, j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i gt = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(a + j)),
+                                        _mm256_loadu_si256((const __m256i*)(b + j)));
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(gt)));
+    }
+    return count + CountGreaterScalar(a + j, b + j, n - j);
+}
 
-    for (int i = history.size() - cycles; i < history.size(); i++) {
-        for (int j = 0; j < nresources; j++) {
-            avg_utilization[j] += history[i].resources[j];
-        }
+__attribute__((target("avx2"))) void AddAvx2(int* dst, const int* src, int n) {
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256i sum = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(dst + j)),
+                                       _mm256_loadu_si256((const __m256i*)(src + j)));
+        _mm256_storeu_si256((__m256i*)(dst + j), sum);
     }
+    AddScalar(dst + j, src + j, n - j);
+}
 
-    for (int j = 0; j < nresources; j++) {
-        avg_utilization[j] = (avg_utilization[j] / cycles) / total_resources[j] * 100;
-        cout << "R" << j << " average utilization (last " << cycles << " cycles): " 
-             << fixed << setprecision(2) << avg_utilization[j] << "%" << endl;
+__attribute__((target("sse4.1"))) bool FitsSse4(const int* a, const int* b, int n) {
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(a + j)),
+                                     _mm_loadu_si128((const __m128i*)(b + j)));
+        if (!_mm_testz_si128(gt, gt)) return false;
     }
-    LogAction("Trends", "Displayed resource utilization trends");
+    return FitsScalar(a + j, b + j, n - j);
 }
 
-// ======================== New Features ========================
+__attribute__((target("sse4.1,popcnt"))) int CountGreaterSse4(const int* a, const int* b, int n) {
+    int count = 0, j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128i gt = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(a + j)),
+                                     _mm_loadu_si128((const __m128i*)(b + j)));
+        count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(gt)));
+    }
+    return count + CountGreaterScalar(a + j, b + j, n - j);
+}
 
-void AddProcess(int max_resources, int priority) {
-    lock_guard<mutex> lock(mtx);
-    process p;
-    p.id = nprocesses;
-    p.Max.resize(nresources, max_resources);
-    p.Allocation.resize(nresources, 0);
-    p.Need = p.Max;
-    p.status = false;
-    p.priority = priority;
-    p.start_time = time(nullptr);
-    p.end_time = 0;
-    p.cpu_usage = (rand() % 50 + 10) / 100.0; // Random CPU usage 0.1-0.6
-    p.wait_time = 0;
-    processes.push_back(p);
-    historical_need[nprocesses] = vector<vector<int>>();
-    nprocesses++;
-    cout << GREEN << "Added process P" << p.id << " with max resources " << max_resources 
-         << " and priority " << priority << RESET << endl;
-    string transaction = "Added process P" + to_string(p.id);
-    AddBlock(transaction);
-    LogAction("AddProcess", "P" + to_string(p.id) + " added");
+__attribute__((target("sse4.1"))) void AddSse4(int* dst, const int* src, int n) {
+    int j = 0;
+    for (; j + 4 <= n; j += 4) {
+        __m128i sum = _mm_add_epi32(_mm_loadu_si128((const __m128i*)(dst + j)),
+                                    _mm_loadu_si128((const __m128i*)(src + j)));
+        _mm_storeu_si128((__m128i*)(dst + j), sum);
+    }
+    AddScalar(dst + j, src + j, n - j);
 }
+#endif
 
-void RemoveProcess(int pid) {
-    lock_guard<mutex> lock(mtx);
-    if (pid < 0 || pid >= nprocesses || processes[pid].status) {
-        cout << RED << "Invalid or already completed process P" << pid << RESET << endl;
-        return;
+RowKernels SelectRowKernels() {
+#ifdef BANKER_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return {"avx2", FitsAvx2, CountGreaterAvx2, AddAvx2};
+    }
+    if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt")) {
+        return {"sse4.1", FitsSse4, CountGreaterSse4, AddSse4};
     }
+#endif
+    return {"scalar", FitsScalar, CountGreaterScalar, AddScalar};
+}
 
-    for (int j = 0; j < nresources; j++) {
-        available[j] += processes[pid].Allocation[j];
+const RowKernels row_kernels = SelectRowKernels();
+
+// Enhanced process structure (resource rows live in the matrices of BankerSystem)
+typedef struct {
+    int id;
+    bool status; // true if completed, false if active
+    int priority;
+    time_t start_time;
+    time_t end_time;
+    double cpu_usage; // Simulated CPU usage
+    int wait_time; // Time spent waiting for resources
+} process;
+
+// ======================== Hashing ========================
+// Streaming 64-bit hashers: fields are fed straight into the state without
+// building an intermediate string. FNV-1a (64-bit offset basis and prime) is
+// the default; build with -DBANKER_HASH_XXH64 to use XXH64 instead, which
+// consumes 32 bytes per round.
+
+struct Fnv1a64 {
+    uint64_t state;
+
+    Fnv1a64() : state(14695981039346656037ULL) {}
+
+    void Update(const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < len; i++) {
+            state ^= p[i];
+            state *= 1099511628211ULL;
+        }
     }
-    processes[pid].status = true;
-    processes[pid].end_time = time(nullptr);
-    cout << GREEN << "Removed process P" << pid << RESET << endl;
-    string transaction = "Removed process P" + to_string(pid);
-    AddBlock(transaction);
-    LogAction("RemoveProcess", "P" + to_string(pid) + " removed");
+
+    uint64_t Final() const { return state; }
+};
+
+struct XxHash64 {
+    static const uint64_t kPrime1 = 11400714785074694791ULL;
+    static const uint64_t kPrime2 = 14029467366897019727ULL;
+    static const uint64_t kPrime3 = 1609587929392839161ULL;
+    static const uint64_t kPrime4 = 9650029242287828579ULL;
+    static const uint64_t kPrime5 = 2870177450012600261ULL;
+
+    uint64_t v[4];
+    uint64_t total;
+    unsigned char buf[32];
+    size_t buffered;
+
+    XxHash64() : total(0), buffered(0) {
+        v[0] = kPrime1 + kPrime2;
+        v[1] = kPrime2;
+        v[2] = 0;
+        v[3] = 0 - kPrime1;
+    }
+
+    static uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+    static uint64_t Round(uint64_t acc, uint64_t input) {
+        return Rotl(acc + input * kPrime2, 31) * kPrime1;
+    }
+    static uint64_t Merge(uint64_t acc, uint64_t val) {
+        return (acc ^ Round(0, val)) * kPrime1 + kPrime4;
+    }
+    static uint64_t Read64(const unsigned char* p) {
+        uint64_t x;
+        memcpy(&x, p, sizeof(x));
+        return x;
+    }
+
+    void Consume(const unsigned char* p) {
+        for (int i = 0; i < 4; i++) v[i] = Round(v[i], Read64(p + 8 * i));
+    }
+
+    void Update(const void* data, size_t len) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        total += len;
+        if (buffered + len < 32) {
+            memcpy(buf + buffered, p, len);
+            buffered += len;
+            return;
+        }
+        if (buffered > 0) {
+            size_t fill = 32 - buffered;
+            memcpy(buf + buffered, p, fill);
+            Consume(buf);
+            p += fill;
+            len -= fill;
+            buffered = 0;
+        }
+        for (; len >= 32; p += 32, len -= 32) Consume(p);
+        memcpy(buf, p, len);
+        buffered = len;
+    }
+
+    uint64_t Final() const {
+        uint64_t h;
+        if (total >= 32) {
+            h = Rotl(v[0], 1) + Rotl(v[1], 7) + Rotl(v[2], 12) + Rotl(v[3], 18);
+            for (int i = 0; i < 4; i++) h = Merge(h, v[i]);
+        } else {
+            h = v[2] + kPrime5; // v[2] still holds the seed
+        }
+        h += total;
+
+        const unsigned char* p = buf;
+        size_t len = buffered;
+        for (; len >= 8; p += 8, len -= 8) {
+            h ^= Round(0, Read64(p));
+            h = Rotl(h, 27) * kPrime1 + kPrime4;
+        }
+        if (len >= 4) {
+            uint32_t k;
+            memcpy(&k, p, sizeof(k));
+            h ^= static_cast<uint64_t>(k) * kPrime1;
+            h = Rotl(h, 23) * kPrime2 + kPrime3;
+            p += 4;
+            len -= 4;
+        }
+        for (; len > 0; p++, len--) {
+            h ^= *p * kPrime5;
+            h = Rotl(h, 11) * kPrime1;
+        }
+        h ^= h >> 33;
+        h *= kPrime2;
+        h ^= h >> 29;
+        h *= kPrime3;
+        h ^= h >> 32;
+        return h;
+    }
+};
+
+#ifdef BANKER_HASH_XXH64
+typedef XxHash64 BlockHasher;
+#define BLOCK_HASH_NAME "XXH64"
+#else
+typedef Fnv1a64 BlockHasher;
+#define BLOCK_HASH_NAME "FNV-1a 64"
+#endif
+
+// Fixed-width lowercase hex rendering of a hash, for display only
+string HashToHex(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    char out[16];
+    for (int i = 15; i >= 0; i--, hash >>= 4) out[i] = digits[hash & 0xf];
+    return string(out, 16);
 }
 
-void RequestResources(int pid, const vector<int>& request) {
-    lock_guard<mutex> lock(mtx);
-    ValidateInput(pid, request, "request");
-    auto start = chrono::high_resolution_clock::now();
+// Blockchain-like security structure
+struct Block {
+    int index;
+    time_t timestamp;
+    string transaction;
+    uint64_t previous_hash;
+    uint64_t hash;
+};
 
-    bool can_request = true;
-    for (int j = 0; j < nresources; j++) {
-        if (request[j] > processes[pid].Need[j] || request[j] > available[j]) {
-            can_request = false;
-            break;
+// Most recent blocks of the chain. Older blocks are evicted from memory
+// once the window is full and paged back in from the ledger on demand.
+const size_t kChainWindow = 4096;
+
+// ======================== Wait-For Graph ========================
+// Rows written since they were last consumed, one bit per process. Resize()
+// and MarkAll() need mtx exclusively. The writer of a row marks it after the
+// write; writers run concurrently (releases hold mtx only shared), and a
+// release marks before EndRelease(), so a consumer that drains inside
+// ReadConsistent() and overlaps the write sees the mark when it retries.
+class DirtyRows {
+public:
+    void Resize(int rows) {
+        size_t words = (rows + 63) / 64;
+        if (words <= words_count_) return;
+        unique_ptr<atomic<uint64_t>[]> bigger(new atomic<uint64_t>[words]);
+        for (size_t w = 0; w < words; w++) {
+            bigger[w].store(w < words_count_ ? words_[w].load() : 0, memory_order_relaxed);
         }
+        words_.swap(bigger);
+        words_count_ = words;
     }
 
-    if (can_request) {
-        vector<process> temp_processes = processes;
-        vector<int> temp_available = available;
+    // Mark exactly rows [0, rows)
+    void MarkAll(int rows) {
+        Resize(rows);
+        for (size_t w = 0; w < words_count_; w++) words_[w].store(0, memory_order_relaxed);
+        for (int p = 0; p < rows; p++) Mark(p);
+    }
 
-        for (int j = 0; j < nresources; j++) {
-            temp_available[j] -= request[j];
-            temp_processes[pid].Allocation[j] += request[j];
-            temp_processes[pid].Need[j] -= request[j];
+    void Mark(int pid) {
+        words_[pid / 64].fetch_or(uint64_t(1) << (pid % 64), memory_order_acq_rel);
+    }
+
+    // Clear the marks of rows [0, rows) and call visit(pid) for each one set
+    template <typename F>
+    void Drain(int rows, F visit) {
+        for (size_t w = 0; w < (static_cast<size_t>(rows) + 63) / 64; w++) {
+            uint64_t bits = words_[w].exchange(0, memory_order_acq_rel);
+            while (bits) {
+                visit(static_cast<int>(w * 64 + __builtin_ctzll(bits)));
+                bits &= bits - 1;
+            }
         }
+    }
 
-        if (IsSafe(temp_processes, temp_available)) {
-            for (int j = 0; j < nresources; j++) {
-                available[j] = temp_available[j];
-                processes[pid].Allocation[j] = temp_processes[pid].Allocation[j];
-                processes[pid].Need[j] = temp_processes[pid].Need[j];
+private:
+    unique_ptr<atomic<uint64_t>[]> words_;
+    size_t words_count_ = 0;
+};
+
+// Deadlock detection on the bipartite wait-for graph: process p -> resource
+// j when p is active and needs more of j than is available, resource j ->
+// process q when q is active and holds some of j. Every cycle through
+// processes of the classic wait-for graph is a cycle here, but the graph has
+// only O(n*m) edges instead of O(n^2*m).
+//
+// The holder lists change only with allocation rows, so they are kept
+// incrementally: every write to a row marks the process dirty, and a
+// detection first refreshes the dirty rows alone. The blocked edges depend
+// on available, which moves on every request and release, so they are
+// derived from Need during the detection. Strongly connected components are
+// then found with an iterative Tarjan pass (no recursion, so no depth limit
+// at thousands of processes); every component with more than one node is a
+// set of deadlocked processes.
+//
+// Locking: Reset() and AddProcess() need mtx exclusively; MarkDirty() follows
+// the DirtyRows rule; FindDeadlockedSets() needs mtx shared and serializes
+// detections itself.
+class WaitForGraph {
+public:
+    void Reset(int nprocesses, int nresources) {
+        n_ = nprocesses;
+        m_ = nresources;
+        holders_.assign(m_, vector<int>());
+        slot_.assign(static_cast<size_t>(n_) * m_, -1);
+        dirty_.MarkAll(n_);
+    }
+
+    void AddProcess() {
+        n_++;
+        slot_.resize(static_cast<size_t>(n_) * m_, -1);
+        dirty_.Resize(n_);
+    }
+
+    void MarkDirty(int pid) { dirty_.Mark(pid); }
+
+    // All sets of deadlocked processes, each sorted, ordered by their lowest
+    // pid. If cycle is given it receives one wait cycle through the first
+    // set (first process repeated at the end), or is cleared if there is none.
+    vector<vector<int>> FindDeadlockedSets(const vector<process>& processes, const ResourceMatrix& need,
+                                           const ResourceMatrix& allocation, const vector<int>& available,
+                                           vector<int>* cycle = nullptr) {
+        lock_guard<mutex> lock(mtx_);
+        ReadConsistent([&] {
+            // Refreshing rows is idempotent, so a retried read only redoes work
+            Refresh(processes, allocation);
+            BuildBlockedEdges(processes, need, available);
+        });
+        RunTarjan();
+
+        vector<vector<int>> sets;
+        for (size_t c = 0; c < component_start_.size(); c++) {
+            size_t begin = component_start_[c];
+            size_t end = c + 1 < component_start_.size() ? component_start_[c + 1] : components_.size();
+            if (end - begin < 2) continue;
+            vector<int> set;
+            for (size_t k = begin; k < end; k++) {
+                if (components_[k] < n_) set.push_back(components_[k]);
             }
-            processes[pid].request_history.insert(processes[pid].request_history.end(), request.begin(), request.end());
-            cout << GREEN << "Request granted for P" << pid << RESET << endl;
-            string transaction = "P" + to_string(pid) + " allocated resources";
-            AddBlock(transaction);
+            sort(set.begin(), set.end());
+            sets.push_back(move(set));
+        }
+        sort(sets.begin(), sets.end());
+        if (cycle) {
+            cycle->clear();
+            if (!sets.empty()) TraceCycle(sets[0][0], *cycle);
+        }
+        return sets;
+    }
+
+private:
+    void Refresh(const vector<process>& processes, const ResourceMatrix& allocation) {
+        dirty_.Drain(n_, [&](int q) {
+            bool active = !processes[q].status;
+            const int* row = allocation.Row(q);
+            for (int j = 0; j < m_; j++) SetHolder(q, j, active && AtomicLoad(row[j]) > 0);
+        });
+    }
+
+    void SetHolder(int q, int j, bool holds) {
+        int& slot = slot_[static_cast<size_t>(q) * m_ + j];
+        if (holds == (slot >= 0)) return;
+        vector<int>& list = holders_[j];
+        if (holds) {
+            slot = static_cast<int>(list.size());
+            list.push_back(q);
         } else {
-            cout << RED << "Request denied: Unsafe state" << RESET << endl;
-            processes[pid].wait_time += 1;
+            int last = list.back();
+            list[slot] = last;
+            slot_[static_cast<size_t>(last) * m_ + j] = slot;
+            list.pop_back();
+            slot = -1;
         }
-    } else {
-        cout << YELLOW << "Request denied: Insufficient resources or exceeds need" << RESET << endl;
-        processes[pid].wait_time += 1;
     }
 
-    sim_stats.requests_processed++;
-    auto end = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::microseconds>(end - start).count();
-    sim_stats.avg_response_time = (sim_stats.avg_response_time * (sim_stats.requests_processed - 1) + duration) / sim_stats.requests_processed;
-    LogAction("Request", "P" + to_string(pid) + " requested resources");
+    // CSR adjacency of process -> resource edges
+    void BuildBlockedEdges(const vector<process>& processes, const ResourceMatrix& need,
+                           const vector<int>& available) {
+        work_.resize(m_);
+        for (int j = 0; j < m_; j++) work_[j] = AtomicLoad(available[j]);
+        blocked_start_.assign(n_ + 1, 0);
+        blocked_.clear();
+        for (int p = 0; p < n_; p++) {
+            if (!processes[p].status) {
+                const int* row = need.Row(p);
+                for (int j = 0; j < m_; j++) {
+                    if (AtomicLoad(row[j]) > work_[j] && !holders_[j].empty()) blocked_.push_back(j);
+                }
+            }
+            blocked_start_[p + 1] = static_cast<int>(blocked_.size());
+        }
+    }
+
+    // Nodes 0..n-1 are processes, n..n+m-1 resources
+    int Degree(int v) const {
+        return v < n_ ? blocked_start_[v + 1] - blocked_start_[v] : static_cast<int>(holders_[v - n_].size());
+    }
+
+    int Edge(int v, int k) const { return v < n_ ? n_ + blocked_[blocked_start_[v] + k] : holders_[v - n_][k]; }
+
+    void RunTarjan() {
+        int nodes = n_ + m_;
+        index_.assign(nodes, -1);
+        low_.assign(nodes, 0);
+        on_stack_.assign(nodes, 0);
+        stack_.clear();
+        components_.clear();
+        component_start_.clear();
+        int next_index = 0;
+        for (int root = 0; root < n_; root++) {
+            if (index_[root] >= 0 || Degree(root) == 0) continue;
+            frames_.clear();
+            frames_.push_back({root, 0});
+            index_[root] = low_[root] = next_index++;
+            stack_.push_back(root);
+            on_stack_[root] = 1;
+            while (!frames_.empty()) {
+                Frame& f = frames_.back();
+                int v = f.node;
+                if (f.next < Degree(v)) {
+                    int w = Edge(v, f.next++);
+                    if (index_[w] < 0) {
+                        index_[w] = low_[w] = next_index++;
+                        stack_.push_back(w);
+                        on_stack_[w] = 1;
+                        frames_.push_back({w, 0});
+                    } else if (on_stack_[w]) {
+                        low_[v] = min(low_[v], index_[w]);
+                    }
+                    continue;
+                }
+                if (low_[v] == index_[v]) {
+                    component_start_.push_back(components_.size());
+                    int w;
+                    do {
+                        w = stack_.back();
+                        stack_.pop_back();
+                        on_stack_[w] = 0;
+                        components_.push_back(w);
+                    } while (w != v);
+                }
+                frames_.pop_back();
+                if (!frames_.empty()) {
+                    int parent = frames_.back().node;
+                    low_[parent] = min(low_[parent], low_[v]);
+                }
+            }
+        }
+    }
+
+    // Shortest wait cycle from start back to itself inside its component
+    void TraceCycle(int start, vector<int>& cycle) {
+        int component = index_[start];
+        for (size_t k = 0; k < component_start_.size(); k++) {
+            size_t begin = component_start_[k];
+            size_t end = k + 1 < component_start_.size() ? component_start_[k + 1] : components_.size();
+            if (find(components_.begin() + begin, components_.begin() + end, start) != components_.begin() + end) {
+                component = static_cast<int>(k);
+                break;
+            }
+        }
+        // Reuse low_ as the component id of each node, index_ as the BFS parent
+        size_t begin = component_start_[component];
+        size_t end = component + 1 < static_cast<int>(component_start_.size()) ? component_start_[component + 1]
+                                                                                 : components_.size();
+        fill(low_.begin(), low_.end(), -1);
+        for (size_t k = begin; k < end; k++) low_[components_[k]] = component;
+        fill(index_.begin(), index_.end(), -1);
+        stack_.assign(1, start);  // BFS queue
+        for (size_t head = 0; head < stack_.size(); head++) {
+            int v = stack_[head];
+            for (int k = 0; k < Degree(v); k++) {
+                int w = Edge(v, k);
+                if (low_[w] != component || index_[w] >= 0) continue;
+                index_[w] = v;
+                if (w == start) {
+                    for (int u = start;; u = index_[u]) {
+                        if (u < n_) cycle.push_back(u);
+                        if (u == start && cycle.size() > 1) break;
+                    }
+                    reverse(cycle.begin(), cycle.end());
+                    return;
+                }
+                stack_.push_back(w);
+            }
+        }
+    }
+
+    struct Frame {
+        int node;
+        int next;  // next edge to follow
+    };
+
+    mutex mtx_;
+    int n_ = 0;
+    int m_ = 0;
+    vector<vector<int>> holders_;  // per resource, the active processes holding some of it
+    vector<int> slot_;             // position of q in holders_[j], or -1
+    DirtyRows dirty_;
+
+    // Scratch of the last detection
+    vector<int> work_;
+    vector<int> blocked_start_;
+    vector<int> blocked_;
+    vector<int> index_, low_, stack_, components_;
+    vector<char> on_stack_;
+    vector<size_t> component_start_;
+    vector<Frame> frames_;
+};
+
+// ======================== State Views ========================
+// Immutable copies of the allocation state for reports, published in the
+// read-copy-update style: a reader takes the current view with an atomic
+// load of a shared_ptr and prints from it for as long as it likes without
+// holding mtx, and each view is freed when its last reader drops it. Views
+// are refreshed only when a reader finds the published one stale. The
+// refresh copies the previous view outside mtx and then, under the shared
+// lock, patches just the rows written since, tracked like the holder lists
+// of the wait-for graph. So a report holds mtx no longer than it takes to
+// copy what changed, and not at all while nothing has.
+struct StateView {
+    uint64_t generation = 0;  // of the state it was taken from
+    int nprocesses = 0;
+    int nresources = 0;
+    vector<process> processes;
+    ResourceMatrix max_matrix;
+    ResourceMatrix allocation_matrix;
+    ResourceMatrix need_matrix;
+    ResourceMatrix request_matrix;
+    vector<int> available;
+    vector<int> total_resources;
+};
+
+class BankerSystem;
+
+// Locking: Reset() and AddProcess() need mtx exclusively; MarkDirty() follows
+// the DirtyRows rule; Acquire() must be called without mtx and serializes
+// refreshes itself.
+class StateViews {
+public:
+    void Reset(int nprocesses) {
+        n_ = nprocesses;
+        dirty_.MarkAll(n_);
+        generation_.fetch_add(1, memory_order_release);
+    }
+
+    void AddProcess() {
+        n_++;
+        dirty_.Resize(n_);
+        MarkDirty(n_ - 1);
+    }
+
+    void MarkDirty(int pid) {
+        dirty_.Mark(pid);
+        generation_.fetch_add(1, memory_order_release);
+    }
+
+    // The published view if nothing has changed since it was taken, else null
+    shared_ptr<const StateView> Current() const {
+        shared_ptr<const StateView> view = atomic_load(&current_);
+        if (view && view->generation == generation_.load(memory_order_acquire)) return view;
+        return nullptr;
+    }
+
+    // The current view of state, refreshed and published first if stale
+    shared_ptr<const StateView> Acquire(const BankerSystem& state);
+
+private:
+    mutex mtx_;
+    int n_ = 0;
+    DirtyRows dirty_;
+    atomic<uint64_t> generation_{0};
+    shared_ptr<const StateView> current_;
+};
+
+// ======================== Resource Partitions ========================
+// The resource types can be split into partitions, disjoint groups of types.
+// A process whose Max, Allocation and Need rows are zero outside one group
+// is a member of that partition; an active process that uses types of
+// several groups, or types in no group, spans every partition it uses.
+//
+// The safety check decomposes over processes that share no resource type:
+// the state is safe exactly when each such set of processes can finish with
+// its own columns of available. So while nothing spans a partition, a
+// request of a member only needs the check over the partition's members and
+// types, and admissions in different partitions can run in parallel. Each
+// partition has its own lock for that: admissions of members take it
+// exclusively and releases of members take it shared, both under mtx shared.
+// Every other request (spanning processes, processes in no partition,
+// members of a spanned partition) takes the cross-partition path, the usual
+// admission under mtx exclusive with the check over the whole state. While
+// the whole state is safe both checks give the same answer.
+//
+// Requests, releases and preemption only move units between the Allocation
+// and Need of the same type, so membership changes only when processes are
+// added, removed or terminated and when the state is replaced, all under mtx
+// exclusive. The declaration is runtime configuration, like the detection
+// mode: it is not part of snapshots or the write-ahead log.
+class ResourcePartitions {
+public:
+    static const int kMaxPartitions = 64;
+
+    // Declare the groups; an empty list turns partitioning off. Fails without
+    // changing anything if a group is empty or a type is out of range or in
+    // two groups. The caller holds mtx exclusively and calls Rebuild() next.
+    bool Configure(const vector<vector<int>>& groups, int nresources, string& error) {
+        if (groups.size() > static_cast<size_t>(kMaxPartitions)) {
+            error = "at most " + to_string(kMaxPartitions) + " partitions";
+            return false;
+        }
+        vector<int> group_of(nresources, -1);
+        for (size_t k = 0; k < groups.size(); k++) {
+            if (groups[k].empty()) {
+                error = "partition " + to_string(k + 1) + " has no resource types";
+                return false;
+            }
+            for (int j : groups[k]) {
+                if (j < 0 || j >= nresources) {
+                    error = "no resource type R" + to_string(j);
+                    return false;
+                }
+                if (group_of[j] >= 0) {
+                    error = "R" + to_string(j) + " is in two partitions";
+                    return false;
+                }
+                group_of[j] = static_cast<int>(k);
+            }
+        }
+        group_of_ = group_of;
+        partitions_.clear();
+        for (const vector<int>& group : groups) {
+            partitions_.emplace_back(new Partition());
+            partitions_.back()->resources = group;
+            sort(partitions_.back()->resources.begin(), partitions_.back()->resources.end());
+        }
+        count_.store(static_cast<int>(groups.size()), memory_order_relaxed);
+        return true;
+    }
+
+    // Reassign every process from its rows after the state was replaced or
+    // the groups declared. A declaration that no longer fits the number of
+    // resource types is dropped. The caller holds mtx exclusively.
+    void Rebuild(const vector<process>& processes, const ResourceMatrix& max_rows,
+                 const ResourceMatrix& alloc_rows, const ResourceMatrix& need_rows) {
+        if (group_of_.size() != static_cast<size_t>(max_rows.cols())) {
+            group_of_.assign(max_rows.cols(), -1);
+            partitions_.clear();
+            count_.store(0, memory_order_relaxed);
+        }
+        for (auto& partition : partitions_) {
+            partition->members.clear();
+            partition->spanning = 0;
+        }
+        partition_of_.clear();
+        slot_.clear();
+        uses_.clear();
+        for (size_t i = 0; i < processes.size(); i++) {
+            int pid = static_cast<int>(i);
+            AddProcess(pid, !processes[i].status, max_rows.Row(pid), alloc_rows.Row(pid), need_rows.Row(pid));
+        }
+    }
+
+    // Assign process pid (the next one) from its rows. The caller holds mtx exclusively.
+    void AddProcess(int pid, bool active, const int* max_row, const int* alloc_row, const int* need_row) {
+        uint64_t uses = 0;
+        bool ungrouped = false;
+        for (size_t j = 0; active && j < group_of_.size(); j++) {
+            if (max_row[j] == 0 && alloc_row[j] == 0 && need_row[j] == 0) continue;
+            if (group_of_[j] < 0) ungrouped = true;
+            else uses |= uint64_t(1) << group_of_[j];
+        }
+        partition_of_.push_back(-1);
+        slot_.push_back(-1);
+        uses_.push_back(uses);
+        if (!ungrouped && uses != 0 && (uses & (uses - 1)) == 0) {
+            int k = 0;
+            while (!(uses >> k & 1)) k++;
+            partition_of_[pid] = k;
+            slot_[pid] = static_cast<int>(partitions_[k]->members.size());
+            partitions_[k]->members.push_back(pid);
+        } else {
+            ForEachUsed(uses, [&](Partition& partition) { partition.spanning++; });
+        }
+    }
+
+    // Drop a finished or terminated process. The caller holds mtx exclusively.
+    void RemoveProcess(int pid) {
+        int k = partition_of_[pid];
+        if (k >= 0) {
+            vector<int>& members = partitions_[k]->members;
+            int last = members.back();
+            members[slot_[pid]] = last;
+            slot_[last] = slot_[pid];
+            members.pop_back();
+        } else {
+            ForEachUsed(uses_[pid], [&](Partition& partition) { partition.spanning--; });
+        }
+        partition_of_[pid] = -1;
+        slot_[pid] = -1;
+        uses_[pid] = 0;
+    }
+
+    // Read without mtx to skip the partitioned path cheaply; rechecked under it
+    bool Enabled() const { return count_.load(memory_order_relaxed) > 0; }
+
+    // The accessors below need mtx, shared at least
+    int Count() const { return static_cast<int>(partitions_.size()); }
+    int PartitionOf(int pid) const {
+        return pid >= 0 && pid < static_cast<int>(partition_of_.size()) ? partition_of_[pid] : -1;
+    }
+    int PartitionOfResource(int j) const { return group_of_[j]; }
+    int Slot(int pid) const { return slot_[pid]; }
+    const vector<int>& Resources(int k) const { return partitions_[k]->resources; }
+    const vector<int>& Members(int k) const { return partitions_[k]->members; }
+    int Spanning(int k) const { return partitions_[k]->spanning; }
+    shared_mutex& Lock(int k) { return partitions_[k]->lock; }
+
+private:
+    struct Partition {
+        vector<int> resources;  // sorted resource types
+        vector<int> members;    // active processes confined to them, in no order
+        int spanning = 0;       // active processes using them and types outside
+        shared_mutex lock;
+    };
+
+    template <typename F>
+    void ForEachUsed(uint64_t uses, F visit) {
+        for (size_t k = 0; k < partitions_.size(); k++) {
+            if (uses >> k & 1) visit(*partitions_[k]);
+        }
+    }
+
+    vector<int> group_of_;                     // per resource type: partition, or -1
+    vector<int> partition_of_;                 // per process: partition it is a member of, or -1
+    vector<int> slot_;                         // per process: index in the members of its partition
+    vector<uint64_t> uses_;                    // per process: bit k set if it uses types of partition k
+    vector<unique_ptr<Partition>> partitions_;
+    atomic<int> count_{0};
+};
+
+// ======================== System State ========================
+
+// Outcome of a single admission decision
+enum class AdmissionOutcome { Granted, DeniedUnsafe, DeniedInsufficient, Invalid };
+
+struct PendingRequest {
+    int pid;
+    vector<int> request;
+};
+
+// One step of deadlock recovery: units taken back from a victim, or the
+// victim terminated with everything it held
+struct RecoveryAction {
+    int pid;
+    bool terminate;
+    vector<int> amounts;
+    double cost;
+};
+
+struct RecoveryReport {
+    vector<int> deadlocked;          // deadlocked processes before recovery
+    vector<RecoveryAction> actions;  // in the order they were applied
+    int rounds;                      // plan/apply/detect rounds
+    bool resolved;                   // no deadlocked process remains
+};
+
+// The allocator as a library. BankerSystem owns the allocation state, the
+// history and the in-memory chain window, and its member functions are the
+// console-free entry points: every result comes back as a return value and
+// nothing is printed. The members are implemented by the free functions of
+// the menu, which work on the state through the reference aliases below, and
+// the locks, ledger and statistics are process-wide. So there is exactly one
+// instance: the constructor is private, copies are not allowed, and
+// Instance() returns the object the aliases refer to, banker.
+class BankerSystem {
+public:
+    static BankerSystem& Instance() {
+        static BankerSystem instance;
+        return instance;
+    }
+    BankerSystem(const BankerSystem&) = delete;
+    BankerSystem& operator=(const BankerSystem&) = delete;
+
+    int nprocesses = 5;
+    int nresources = 4;
+    vector<process> processes;
+    ResourceMatrix max_matrix;        // per-process resource rows, indexed by process ID
+    ResourceMatrix allocation_matrix;
+    ResourceMatrix need_matrix;
+    ResourceMatrix request_matrix;    // outstanding request: the last one denied within Need, cleared on a grant
+    vector<int> available;
+    vector<int> total_resources;
+    HistoryRing history;          // granted and released amounts
+    HistoryRing historical_need;  // need rows sampled by the load generator
+    HistoryStats history_stats;   // streaming statistics over history
+    WaitForGraph wait_for_graph;  // holder lists for deadlock detection
+    StateViews state_views;       // published copies for reports
+    ResourcePartitions partitions; // partitioned admission (see ResourcePartitions)
+    deque<Block> blockchain;
+    int chain_length = 0; // total blocks in the chain, including evicted ones
+
+    // Defined in the Library API section
+    void Reset();
+    bool LoadConfig(const string& filename, string* error = nullptr);
+    bool ExportConfig(const string& filename);
+    bool SaveSnapshot(const string& filename, string* error = nullptr);
+    bool LoadSnapshot(const string& filename, string* error = nullptr);
+    bool Checkpoint(string* error = nullptr);
+    shared_ptr<const StateView> View();
+    bool SetPartitions(const vector<vector<int>>& groups, string* error = nullptr);
+    bool IsSafe(vector<int>* sequence = nullptr);
+    AdmissionOutcome Request(int pid, const vector<int>& request);
+    vector<AdmissionOutcome> RequestBatch(const vector<PendingRequest>& batch);
+    bool Release(int pid, const vector<int>& release);
+    int AddProcess(int max_resources, int priority, const vector<int>& resources = {});
+    bool RemoveProcess(int pid);
+    vector<int> FindDeadlockCycle();
+    vector<vector<int>> FindDeadlockedSets();
+    vector<int> FindDeadlockedProcesses();
+    RecoveryReport RecoverDeadlock();
+    bool VerifyChain(int* first_bad = nullptr);
+    int ProcessCount();
+    vector<int> Available();
+
+private:
+    BankerSystem() {}
+};
+
+BankerSystem& banker = BankerSystem::Instance();
+
+int& nprocesses = banker.nprocesses;
+int& nresources = banker.nresources;
+vector<process>& processes = banker.processes;
+ResourceMatrix& max_matrix = banker.max_matrix;
+ResourceMatrix& allocation_matrix = banker.allocation_matrix;
+ResourceMatrix& need_matrix = banker.need_matrix;
+ResourceMatrix& request_matrix = banker.request_matrix;
+vector<int>& available = banker.available;
+vector<int>& total_resources = banker.total_resources;
+HistoryRing& history = banker.history;
+HistoryRing& historical_need = banker.historical_need;
+HistoryStats& history_stats = banker.history_stats;
+WaitForGraph& wait_for_graph = banker.wait_for_graph;
+StateViews& state_views = banker.state_views;
+ResourcePartitions& partitions = banker.partitions;
+deque<Block>& blockchain = banker.blockchain;
+int& chain_length = banker.chain_length;
+
+// Note a write to the row of pid for the wait-for graph and the state views
+void MarkRowWritten(int pid) {
+    wait_for_graph.MarkDirty(pid);
+    state_views.MarkDirty(pid);
 }
 
-void ReleaseResources(int pid, const vector<int>& release) {
-    lock_guard<mutex> lock(mtx);
-    ValidateInput(pid, release, "release");
+shared_ptr<const StateView> StateViews::Acquire(const BankerSystem& state) {
+    shared_ptr<const StateView> view = Current();
+    if (view) return view;
+    lock_guard<mutex> lock(mtx_);
+    // A refresh that finished while this one waited may have done the work
+    view = Current();
+    if (view) return view;
+
+    shared_ptr<const StateView> previous = atomic_load(&current_);
+    shared_ptr<StateView> next = previous ? make_shared<StateView>(*previous) : make_shared<StateView>();
+    {
+        shared_lock<shared_mutex> state_lock(mtx);
+        next->generation = generation_.load(memory_order_acquire);
+        const int n = state.nprocesses, m = state.nresources;
+        // Shape changes other than added processes come with a Reset()
+        bool full = !previous || next->nresources != m || next->nprocesses > n;
+        if (full) {
+            for (ResourceMatrix* matrix : {&next->max_matrix, &next->allocation_matrix, &next->need_matrix,
+                                           &next->request_matrix}) {
+                matrix->Reset(n, m);
+            }
+        } else {
+            for (int i = next->nprocesses; i < n; i++) {
+                next->max_matrix.AppendRow(0);
+                next->allocation_matrix.AppendRow(0);
+                next->need_matrix.AppendRow(0);
+                next->request_matrix.AppendRow(0);
+            }
+        }
+        next->nprocesses = n;
+        next->nresources = m;
+        next->processes.resize(n);
+        auto copy_row = [&](int i) {
+            next->processes[i] = state.processes[i];
+            copy(state.max_matrix.Row(i), state.max_matrix.Row(i) + m, next->max_matrix.Row(i));
+            copy(state.allocation_matrix.Row(i), state.allocation_matrix.Row(i) + m, next->allocation_matrix.Row(i));
+            copy(state.need_matrix.Row(i), state.need_matrix.Row(i) + m, next->need_matrix.Row(i));
+            copy(state.request_matrix.Row(i), state.request_matrix.Row(i) + m, next->request_matrix.Row(i));
+        };
+        ReadConsistent([&] {
+            // As in WaitForGraph, a release overlapping this read marks its
+            // row again, so the retry copies it after the release is done
+            dirty_.Drain(n, copy_row);
+            if (full) {
+                for (int i = 0; i < n; i++) copy_row(i);
+            }
+            next->available = state.available;
+            next->total_resources = state.total_resources;
+        });
+    }
+    atomic_store(&current_, shared_ptr<const StateView>(next));
+    return next;
+}
 
-    bool can_release = true;
-    for (int j = 0; j < nresources; j++) {
-        if (release[j] > processes[pid].Allocation[j]) {
-            can_release = false;
-            break;
+// ======================== Block Ledger ========================
+// Append-only binary ledger backing the chain. The file starts with an
+// 8-byte magic followed by length-prefixed records:
+//   u32 payload length | i32 index | i64 timestamp |
+//   u64 previous hash | u64 hash | u32 + transaction
+// Append() only encodes the block into a pending buffer; a committer thread
+// writes everything queued since its last round with one write and one
+// fsync (group commit), so callers never wait on the disk.
+class BlockLedger {
+public:
+    static const int kIndexStride = 256; // one sparse index entry per this many blocks
+
+    BlockLedger() : file_(nullptr), open_(false), append_offset_(0), pending_last_(-1), durable_index_(-1) {}
+    ~BlockLedger() { Close(); }
+
+    // Start a new, empty ledger at path
+    bool Open(const string& path) {
+        Close();
+        file_ = fopen(path.c_str(), "wb");
+        if (!file_) return false;
+        path_ = path;
+        fwrite(kMagic, 1, sizeof(kMagic), file_);
+        fflush(file_);
+        append_offset_ = sizeof(kMagic);
+        {
+            lock_guard<mutex> lock(mtx_);
+            sparse_index_.clear();
+            pending_.clear();
+            pending_last_ = -1;
+            durable_index_ = -1;
+            open_ = true;
         }
+        committer_ = thread(&BlockLedger::CommitLoop, this);
+        return true;
     }
 
-    if (can_release) {
-        for (int j = 0; j < nresources; j++) {
-            available[j] += release[j];
-            processes[pid].Allocation[j] -= release[j];
-            processes[pid].Need[j] += release[j];
+    // Flush everything still pending and stop the committer
+    void Close() {
+        {
+            lock_guard<mutex> lock(mtx_);
+            if (!open_) return;
+            open_ = false;
         }
-        cout << GREEN << "Resources released for P" << pid << RESET << endl;
-        string transaction = "P" + to_string(pid) + " released resources";
-        AddBlock(transaction);
+        pending_cv_.notify_one();
+        committer_.join();
+        fclose(file_);
+        file_ = nullptr;
+    }
 
-        AllocationHistory h;
-        h.pid = pid;
-        h.resources = release;
-        h.timestamp = time(nullptr);
-        h.action = "release";
-        history.push_back(h);
-    } else {
-        cout << RED << "Cannot release: Exceeds allocated resources" << RESET << endl;
+    void Append(const Block& block) {
+        string record;
+        Encode(block, record);
+        {
+            lock_guard<mutex> lock(mtx_);
+            if (!open_) return;
+            if (block.index % kIndexStride == 0) {
+                sparse_index_.push_back(make_pair(block.index, append_offset_));
+            }
+            append_offset_ += record.size();
+            pending_ += record;
+            pending_last_ = block.index;
+        }
+        pending_cv_.notify_one();
     }
-    LogAction("Release", "P" + to_string(pid) + " released resources");
+
+    // open_ is written by Close() under mtx_, so it is read under it as well
+    bool IsOpen() {
+        lock_guard<mutex> lock(mtx_);
+        return open_;
+    }
+
+    // Block until every block up to index has been fsynced
+    void WaitDurable(int index) {
+        unique_lock<mutex> lock(mtx_);
+        durable_cv_.wait(lock, [&] { return durable_index_ >= index || !open_; });
+    }
+
+    // Append count blocks starting at first, read back from disk, to out.
+    // Every call uses its own file handle, so several threads can page
+    // blocks in concurrently.
+    bool ReadBlocks(int first, int count, vector<Block>& out) {
+        if (count <= 0) return true;
+        if (!IsOpen()) return false;
+        size_t base = out.size();
+        WaitDurable(first + count - 1);
+
+        uint64_t offset = sizeof(kMagic);
+        {
+            lock_guard<mutex> lock(mtx_);
+            auto it = upper_bound(sparse_index_.begin(), sparse_index_.end(), make_pair(first, UINT64_MAX));
+            if (it != sparse_index_.begin()) offset = (--it)->second;
+        }
+
+        FILE* in = fopen(path_.c_str(), "rb");
+        if (!in) return false;
+        fseek(in, static_cast<long>(offset), SEEK_SET);
+        string payload;
+        while (static_cast<int>(out.size() - base) < count) {
+            uint32_t len;
+            if (fread(&len, sizeof(len), 1, in) != 1) break;
+            payload.resize(len);
+            if (fread(&payload[0], 1, len, in) != len) break;
+            Block block;
+            if (!Decode(payload, block)) break;
+            if (block.index >= first) out.push_back(block);
+        }
+        fclose(in);
+        return static_cast<int>(out.size() - base) == count;
+    }
+
+    // Copy every record written so far, in ledger encoding, to out once the
+    // last one (index last) is durable. The caller must hold chain_mtx so
+    // nothing is appended meanwhile.
+    bool ReadRecords(int last, string& out) {
+        if (!IsOpen()) return false;
+        WaitDurable(last);
+        uint64_t size;
+        {
+            lock_guard<mutex> lock(mtx_);
+            size = append_offset_ - sizeof(kMagic);
+        }
+        FILE* in = fopen(path_.c_str(), "rb");
+        if (!in) return false;
+        out.resize(size);
+        fseek(in, sizeof(kMagic), SEEK_SET);
+        bool ok = fread(&out[0], 1, size, in) == size;
+        fclose(in);
+        return ok;
+    }
+
+    // Start a new ledger at path holding count encoded records (as copied by
+    // ReadRecords) and decode the newest window_size of them into window.
+    // Nothing is touched unless every record decodes with the expected index.
+    bool Restore(const string& path, const char* records, size_t size, int count, size_t window_size,
+                 deque<Block>& window) {
+        vector<pair<int, uint64_t>> sparse_index;
+        deque<Block> tail;
+        size_t pos = 0;
+        string payload;
+        for (int index = 0; index < count; index++) {
+            uint32_t len;
+            if (pos + sizeof(len) > size) return false;
+            memcpy(&len, records + pos, sizeof(len));
+            if (len < sizeof(int32_t) || len > size - pos - sizeof(len)) return false;
+            int32_t recorded;
+            memcpy(&recorded, records + pos + sizeof(len), sizeof(recorded));
+            if (recorded != index) return false;
+            if (index % kIndexStride == 0) sparse_index.push_back(make_pair(index, sizeof(kMagic) + pos));
+            if (static_cast<size_t>(count - index) <= window_size) {
+                Block block;
+                payload.assign(records + pos + sizeof(len), len);
+                if (!Decode(payload, block)) return false;
+                tail.push_back(move(block));
+            }
+            pos += sizeof(len) + len;
+        }
+        if (pos != size || !Open(path)) return false;
+
+        {
+            lock_guard<mutex> lock(mtx_);
+            sparse_index_ = move(sparse_index);
+            pending_.assign(records, size);
+            append_offset_ += size;
+            pending_last_ = count - 1;
+        }
+        pending_cv_.notify_one();
+        window.swap(tail);
+        return true;
+    }
+
+private:
+    static constexpr char kMagic[8] = {'B', 'L', 'E', 'D', 'G', 'E', 'R', '2'};
+
+    template <typename T> static void Put(string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    template <typename T> static bool Get(const string& in, size_t& pos, T& value) {
+        if (pos + sizeof(value) > in.size()) return false;
+        memcpy(&value, in.data() + pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
+    }
+    template <typename L> static bool GetString(const string& in, size_t& pos, string& value) {
+        L len;
+        if (!Get(in, pos, len) || pos + len > in.size()) return false;
+        value.assign(in, pos, len);
+        pos += len;
+        return true;
+    }
+
+    static void Encode(const Block& block, string& out) {
+        string payload;
+        Put<int32_t>(payload, block.index);
+        Put<int64_t>(payload, block.timestamp);
+        Put<uint64_t>(payload, block.previous_hash);
+        Put<uint64_t>(payload, block.hash);
+        Put<uint32_t>(payload, block.transaction.size());
+        payload += block.transaction;
+        Put<uint32_t>(out, payload.size());
+        out += payload;
+    }
+
+    static bool Decode(const string& in, Block& block) {
+        size_t pos = 0;
+        int32_t index;
+        int64_t timestamp;
+        if (!Get(in, pos, index) || !Get(in, pos, timestamp)) return false;
+        block.index = index;
+        block.timestamp = timestamp;
+        return Get(in, pos, block.previous_hash) &&
+               Get(in, pos, block.hash) &&
+               GetString<uint32_t>(in, pos, block.transaction);
+    }
+
+    void CommitLoop() {
+        unique_lock<mutex> lock(mtx_);
+        while (true) {
+            pending_cv_.wait(lock, [&] { return !pending_.empty() || !open_; });
+            if (pending_.empty()) break; // closed and fully drained
+            string batch;
+            batch.swap(pending_);
+            int last = pending_last_;
+            lock.unlock();
+
+            fwrite(batch.data(), 1, batch.size(), file_);
+            fflush(file_);
+#ifdef _WIN32
+            _commit(_fileno(file_));
+#else
+            fsync(fileno(file_));
+#endif
+
+            lock.lock();
+            durable_index_ = last;
+            durable_cv_.notify_all();
+        }
+        durable_cv_.notify_all();
+    }
+
+    FILE* file_;
+    string path_;
+    bool open_;
+    uint64_t append_offset_;
+    vector<pair<int, uint64_t>> sparse_index_; // block index -> file offset
+    string pending_;
+    int pending_last_;
+    int durable_index_;
+    mutex mtx_;
+    condition_variable pending_cv_;
+    condition_variable durable_cv_;
+    thread committer_;
+};
+
+constexpr char BlockLedger::kMagic[8];
+
+BlockLedger ledger;
+
+int ChainLength() {
+    lock_guard<mutex> lock(chain_mtx);
+    return chain_length;
+}
+
+// Copy blocks [first, first + count) into out, from the in-memory window
+// where possible and from the ledger for evicted ones. The disk reads run
+// outside chain_mtx; blocks evicted in the meantime are read from disk on
+// the next round.
+bool LoadBlocks(int first, int count, vector<Block>& out) {
+    out.clear();
+    while (count > 0) {
+        int from_disk;
+        {
+            lock_guard<mutex> lock(chain_mtx);
+            int window_start = chain_length - static_cast<int>(blockchain.size());
+            if (first >= window_start) {
+                if (first + count > chain_length) return false;
+                for (int i = first; i < first + count; i++) {
+                    out.push_back(blockchain[i - window_start]);
+                }
+                return true;
+            }
+            from_disk = min(count, window_start - first);
+        }
+        if (!ledger.ReadBlocks(first, from_disk, out)) return false;
+        first += from_disk;
+        count -= from_disk;
+    }
+    return true;
+}
+
+// Simulation statistics
+struct SimulationStats {
+    atomic<int> requests_processed; // also bumped by partitioned admissions
+    atomic<int> deadlocks_detected; // also bumped by readers under shared mtx
+    int deadlocks_resolved;
+    int total_cycles;
+};
+
+SimulationStats sim_stats = {0, 0, 0, 0};
+
+// ======================== Logging ========================
+
+enum class LogLevel { Debug, Info, Warn, Error };
+
+const char* LogLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info: return "INFO";
+        case LogLevel::Warn: return "WARN";
+        case LogLevel::Error: return "ERROR";
+    }
+    return "INFO";
+}
+
+// Background logger. Callers format their message into a slot of a bounded
+// lock-free ring (multi-producer, single-consumer) and return immediately; a
+// writer thread drains the ring every flush interval and appends the batch
+// to one persistent file handle with a single write. Enqueueing never takes
+// a lock or makes a syscall; when the ring is full the message is dropped
+// and counted instead of blocking the caller.
+class AsyncLogger {
+public:
+    static const size_t kCapacity = 4096; // power of two
+    static const size_t kMessageSize = 240;
+
+    AsyncLogger() : enqueue_pos_(0), dequeue_pos_(0), dropped_(0), min_level_(LogLevel::Info),
+                    flush_interval_ms_(100), running_(false), file_(nullptr) {
+        for (size_t i = 0; i < kCapacity; i++) slots_[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    ~AsyncLogger() { Stop(); }
+
+    void Start(const string& path) {
+        if (running_) return;
+        file_ = fopen(path.c_str(), "a");
+        if (!file_) return;
+        running_ = true;
+        writer_ = thread(&AsyncLogger::WriterLoop, this);
+    }
+
+    // Stop the writer thread after draining everything already enqueued
+    void Stop() {
+        if (!running_) return;
+        running_ = false;
+        writer_.join();
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+    void SetLevel(LogLevel level) { min_level_ = level; }
+    LogLevel Level() const { return min_level_; }
+    void SetFlushInterval(int ms) { flush_interval_ms_ = max(1, ms); }
+    int FlushInterval() const { return flush_interval_ms_; }
+    uint64_t Dropped() const { return dropped_.load(memory_order_relaxed); }
+
+    bool Enqueue(LogLevel level, const string& action, const string& details) {
+        if (level < min_level_) return true;
+        size_t pos = enqueue_pos_.load(memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & (kCapacity - 1)];
+            size_t seq = slot->sequence.load(memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                dropped_.fetch_add(1, memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueue_pos_.load(memory_order_relaxed);
+            }
+        }
+        slot->timestamp = time(nullptr);
+        slot->level = level;
+        snprintf(slot->text, kMessageSize, "%s: %s", action.c_str(), details.c_str());
+        slot->sequence.store(pos + 1, memory_order_release);
+        return true;
+    }
+
+private:
+    struct Slot {
+        atomic<size_t> sequence;
+        time_t timestamp;
+        LogLevel level;
+        char text[kMessageSize];
+    };
+
+    // Move every published slot into buf; returns the number of messages
+    size_t Drain(string& buf) {
+        size_t count = 0;
+        char stamp[64];
+        while (true) {
+            Slot& slot = slots_[dequeue_pos_ & (kCapacity - 1)];
+            if (slot.sequence.load(memory_order_acquire) != dequeue_pos_ + 1) break;
+            struct tm local;
+#ifdef _WIN32
+            localtime_s(&local, &slot.timestamp);
+#else
+            localtime_r(&slot.timestamp, &local);
+#endif
+            strftime(stamp, sizeof(stamp), "%a %b %e %H:%M:%S %Y", &local);
+            buf += stamp;
+            buf += "\n";
+            buf += LogLevelName(slot.level);
+            buf += " ";
+            buf += slot.text;
+            buf += "\n";
+            slot.sequence.store(dequeue_pos_ + kCapacity, memory_order_release);
+            dequeue_pos_++;
+            count++;
+        }
+        return count;
+    }
+
+    void WriterLoop() {
+        string buf;
+        while (true) {
+            bool stopping = !running_;
+            buf.clear();
+            Drain(buf);
+            uint64_t dropped = dropped_.exchange(0, memory_order_relaxed);
+            if (dropped > 0) {
+                buf += "WARN Logger: " + to_string(dropped) + " messages dropped (ring full)\n";
+            }
+            if (!buf.empty()) {
+                fwrite(buf.data(), 1, buf.size(), file_);
+                fflush(file_);
+            }
+            if (stopping) break;
+            this_thread::sleep_for(chrono::milliseconds(flush_interval_ms_.load()));
+        }
+    }
+
+    Slot slots_[kCapacity];
+    atomic<size_t> enqueue_pos_;
+    size_t dequeue_pos_; // writer thread only
+    atomic<uint64_t> dropped_;
+    atomic<LogLevel> min_level_;
+    atomic<int> flush_interval_ms_;
+    atomic<bool> running_;
+    FILE* file_;
+    thread writer_;
+};
+
+AsyncLogger logger;
+
+void LogMessage(LogLevel level, const string& action, const string& details) {
+    ScopedLatency timer(LatencyOp::LogWrite);
+    logger.Enqueue(level, action, details);
+}
+
+// Logging function
+void LogAction(const string& action, const string& details) {
+    LogMessage(LogLevel::Info, action, details);
+}
+
+// ======================== Trace Recording ========================
+// Binary trace of every state-changing operation, for reproducing captured
+// workloads with ReplayTrace(). The file starts with an 8-byte magic
+// followed by records:
+//   u64 t_ns | i32 pid | u32 count | u8 op | u8 outcome | payload
+// t_ns counts from the start of the recording. The payload is count i32
+// values (request / release / preempted amounts, or for add the max, the
+// priority, the cpu_usage in hundredths and the resource types the max
+// applies to, all if none follow)
+// or, for snapshots, count bytes of state text in the system_state.txt
+// format. Every recording opens with a snapshot, and resets and config loads
+// add a new one, so a replay always starts from the recorded state.
+// Operations are recorded inside their critical section, so records of
+// admissions and structural changes appear in the order they took effect.
+// Only releases and admissions in different resource partitions can run
+// concurrently with each other, and those touch disjoint rows and columns
+// or only add to available, so they commute.
+enum class TraceOp : uint8_t { Snapshot, Request, Release, AddProcess, RemoveProcess, Preempt };
+
+// Outcome byte of a snapshot record
+enum class SnapshotReason : uint8_t { Start, Reset, Load };
+
+class TraceRecorder {
+public:
+    static const char kMagic[9];
+
+    ~TraceRecorder() { Stop(); }
+
+    // The caller must hold mtx exclusively and pass the current state text,
+    // so no operation can slip in between the snapshot and the first record
+    bool Start(const string& path, const string& state_text) {
+        lock_guard<mutex> lock(mtx_);
+        if (file_) return false;
+        file_ = fopen(path.c_str(), "wb");
+        if (!file_) return false;
+        fwrite(kMagic, 1, 8, file_);
+        origin_ = chrono::steady_clock::now();
+        records_ = 0;
+        AppendSnapshot(SnapshotReason::Start, state_text);
+        recording_.store(true, memory_order_release);
+        return true;
+    }
+
+    uint64_t Stop() {
+        lock_guard<mutex> lock(mtx_);
+        if (!file_) return 0;
+        recording_.store(false, memory_order_release);
+        Flush();
+        fclose(file_);
+        file_ = nullptr;
+        return records_;
+    }
+
+    bool Recording() const { return recording_.load(memory_order_acquire); }
+
+    void Record(TraceOp op, int pid, const int* values, size_t count, int outcome) {
+        lock_guard<mutex> lock(mtx_);
+        if (!file_) return;
+        AppendHeader(op, pid, static_cast<uint32_t>(count), outcome);
+        for (size_t k = 0; k < count; k++) Put<int32_t>(values[k]);
+        if (buffer_.size() >= kFlushBytes) Flush();
+    }
+
+    void RecordSnapshot(SnapshotReason reason, const string& state_text) {
+        lock_guard<mutex> lock(mtx_);
+        if (!file_) return;
+        AppendSnapshot(reason, state_text);
+        if (buffer_.size() >= kFlushBytes) Flush();
+    }
+
+private:
+    static const size_t kFlushBytes = 1 << 20;
+
+    template <typename T>
+    void Put(T value) {
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void AppendHeader(TraceOp op, int pid, uint32_t count, int outcome) {
+        auto t = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin_).count();
+        Put<uint64_t>(static_cast<uint64_t>(t));
+        Put<int32_t>(pid);
+        Put<uint32_t>(count);
+        Put<uint8_t>(static_cast<uint8_t>(op));
+        Put<uint8_t>(static_cast<uint8_t>(outcome));
+        records_++;
+    }
+
+    void AppendSnapshot(SnapshotReason reason, const string& state_text) {
+        AppendHeader(TraceOp::Snapshot, -1, static_cast<uint32_t>(state_text.size()), static_cast<int>(reason));
+        buffer_ += state_text;
+    }
+
+    void Flush() {
+        if (!buffer_.empty()) fwrite(buffer_.data(), 1, buffer_.size(), file_);
+        buffer_.clear();
+        fflush(file_);
+    }
+
+    mutex mtx_;
+    FILE* file_ = nullptr;
+    string buffer_;
+    atomic<bool> recording_{false};
+    chrono::steady_clock::time_point origin_;
+    uint64_t records_ = 0;
+};
+
+const char TraceRecorder::kMagic[9] = "BTRACE01";
+
+TraceRecorder trace;
+
+// ======================== Write-Ahead Log ========================
+// Durable log of every state-changing operation, for crash recovery. It
+// records the same operations as the trace, at the same points inside their
+// critical sections, and recovery replays them the same way: from the last
+// checkpoint (a binary snapshot) through the quiet Try* paths, which decide
+// as they did the first time. The file starts with
+//   8-byte magic | u32 epoch | u32 reserved
+// followed by records
+//   u32 body length | u32 checksum | i32 pid | u32 count | u8 op | u8 outcome | payload
+// with the trace's ops and payloads. The checksum is the low half of the
+// XXH64 of the body, so a record torn by a crash ends the replay instead of
+// feeding it garbage. The epoch names the checkpoint the log continues: a
+// checkpoint saves the snapshot with the next epoch first and only then
+// replaces the log, so a crash in between leaves a log that recovery knows
+// the checkpoint already covers.
+//
+// Append() only encodes into a pending buffer. A committer thread writes
+// and fsyncs everything queued since its last round at once (group commit).
+// In synchronous mode an operation returns once its record is durable, but
+// it waits after leaving its critical section (see WalCommit), so no fsync
+// ever runs under mtx and concurrent operations share one.
+class WriteAheadLog {
+public:
+    static const char kMagic[9];
+    static constexpr size_t kHeaderBytes = 16;
+    static const size_t kRecordHeaderBytes = 8;  // length and checksum
+    static const size_t kBodyHeaderBytes = 10;   // pid, count, op, outcome
+    static const uint64_t kDefaultCheckpointBytes = 64ull << 20;
+
+    ~WriteAheadLog() { Close(); }
+
+    // Start a new, empty log at base.wal continuing the checkpoint at
+    // base.ckpt that was saved with this epoch
+    bool Open(const string& base, uint32_t epoch) {
+        Close();
+        FILE* file = CreateLog(base + ".wal", epoch);
+        if (!file) return false;
+        path_ = base + ".wal";
+        checkpoint_path_ = base + ".ckpt";
+        file_ = file;
+        epoch_ = epoch;
+        pending_.clear();
+        bytes_ = kHeaderBytes;
+        next_checkpoint_ = checkpoint_bytes_;
+        checkpoint_claimed_ = false;
+        checkpoint_lsn_ = appended_lsn_;
+        durable_lsn_ = appended_lsn_;
+        open_ = true;
+        committer_ = thread(&WriteAheadLog::CommitLoop, this);
+        enabled_.store(true, memory_order_release);
+        return true;
+    }
+
+    // Make everything appended so far durable and stop the committer
+    void Close() {
+        {
+            lock_guard<mutex> lock(mtx_);
+            if (!open_) return;
+            open_ = false;
+        }
+        enabled_.store(false, memory_order_release);
+        pending_cv_.notify_one();
+        committer_.join();
+        fclose(file_);
+        file_ = nullptr;
+    }
+
+    bool Enabled() const { return enabled_.load(memory_order_acquire); }
+
+    // The append functions return the sequence number of the record, 0 if the log is not open
+    uint64_t Append(TraceOp op, int pid, const int* values, size_t count, int outcome) {
+        return AppendRecord(op, pid, static_cast<uint32_t>(count), outcome, values, count * sizeof(int32_t));
+    }
+
+    uint64_t AppendSnapshot(SnapshotReason reason, const string& state_text) {
+        return AppendRecord(TraceOp::Snapshot, -1, static_cast<uint32_t>(state_text.size()), static_cast<int>(reason),
+                     state_text.data(), state_text.size());
+    }
+
+    // Block until every record up to lsn has been fsynced
+    void WaitDurable(uint64_t lsn) {
+        unique_lock<mutex> lock(mtx_);
+        durable_cv_.wait(lock, [&] { return durable_lsn_ >= lsn || !open_; });
+    }
+
+    // Replace the log with an empty one for the checkpoint just saved with
+    // epoch. The caller must hold mtx exclusively, so nothing is appended
+    // meanwhile; records still pending are covered by the checkpoint.
+    bool Rotate(uint32_t epoch) {
+        lock_guard<mutex> io_lock(io_mtx_);
+        FILE* file = CreateLog(path_, epoch);
+        if (!file) return false;
+        lock_guard<mutex> lock(mtx_);
+        fclose(file_);
+        file_ = file;
+        epoch_ = epoch;
+        pending_.clear();
+        bytes_ = kHeaderBytes;
+        next_checkpoint_ = checkpoint_bytes_;
+        checkpoint_claimed_ = false;
+        checkpoint_lsn_ = appended_lsn_;
+        durable_lsn_ = appended_lsn_;
+        durable_cv_.notify_all();
+        return true;
+    }
+
+    // True once per time the log outgrows the checkpoint threshold; the
+    // caller then checkpoints, or calls PostponeCheckpoint() if it cannot
+    bool TakeCheckpointDue() {
+        lock_guard<mutex> lock(mtx_);
+        if (!open_ || checkpoint_claimed_ || bytes_ < next_checkpoint_) return false;
+        checkpoint_claimed_ = true;
+        return true;
+    }
+
+    void PostponeCheckpoint() {
+        lock_guard<mutex> lock(mtx_);
+        next_checkpoint_ = bytes_ + checkpoint_bytes_;
+        checkpoint_claimed_ = false;
+    }
+
+    bool Synchronous() const { return synchronous_.load(memory_order_relaxed); }
+    void SetSynchronous(bool synchronous) { synchronous_.store(synchronous, memory_order_relaxed); }
+
+    uint64_t CheckpointBytes() const {
+        lock_guard<mutex> lock(mtx_);
+        return checkpoint_bytes_;
+    }
+
+    void SetCheckpointBytes(uint64_t bytes) {
+        lock_guard<mutex> lock(mtx_);
+        checkpoint_bytes_ = max<uint64_t>(bytes, kHeaderBytes);
+        next_checkpoint_ = checkpoint_bytes_;
+    }
+
+    const string& Path() const { return path_; }
+    const string& CheckpointPath() const { return checkpoint_path_; }
+
+    uint32_t Epoch() const {
+        lock_guard<mutex> lock(mtx_);
+        return epoch_;
+    }
+
+    // Records appended since the last checkpoint, how many of them are
+    // durable, and the size of the log file they make up
+    void Status(uint64_t& records, uint64_t& durable, uint64_t& bytes) const {
+        lock_guard<mutex> lock(mtx_);
+        records = appended_lsn_ - checkpoint_lsn_;
+        durable = durable_lsn_ - checkpoint_lsn_;
+        bytes = bytes_;
+    }
+
+private:
+    template <typename T>
+    static void Put(string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    static void Sync(FILE* file) {
+        fflush(file);
+#ifdef _WIN32
+        _commit(_fileno(file));
+#else
+        fsync(fileno(file));
+#endif
+    }
+
+    // Write a log holding only the header through a temporary file and
+    // reopen it for appending, so path always holds a complete header
+    static FILE* CreateLog(const string& path, uint32_t epoch) {
+        string temp = path + ".tmp";
+        FILE* file = fopen(temp.c_str(), "wb");
+        if (!file) return nullptr;
+        string header(kMagic, 8);
+        Put<uint32_t>(header, epoch);
+        Put<uint32_t>(header, 0);
+        bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+        Sync(file);
+        ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+        if (ok) remove(path.c_str());
+#endif
+        if (!ok || rename(temp.c_str(), path.c_str()) != 0) {
+            remove(temp.c_str());
+            return nullptr;
+        }
+        return fopen(path.c_str(), "ab");
+    }
+
+    uint64_t AppendRecord(TraceOp op, int pid, uint32_t count, int outcome, const void* payload, size_t bytes) {
+        if (!Enabled()) return 0;
+        string body;
+        body.reserve(kBodyHeaderBytes + bytes);
+        Put<int32_t>(body, pid);
+        Put<uint32_t>(body, count);
+        Put<uint8_t>(body, static_cast<uint8_t>(op));
+        Put<uint8_t>(body, static_cast<uint8_t>(outcome));
+        body.append(static_cast<const char*>(payload), bytes);
+        XxHash64 hasher;
+        hasher.Update(body.data(), body.size());
+        uint64_t lsn;
+        {
+            lock_guard<mutex> lock(mtx_);
+            if (!open_) return 0;
+            Put<uint32_t>(pending_, static_cast<uint32_t>(body.size()));
+            Put<uint32_t>(pending_, static_cast<uint32_t>(hasher.Final()));
+            pending_ += body;
+            bytes_ += kRecordHeaderBytes + body.size();
+            lsn = ++appended_lsn_;
+        }
+        pending_cv_.notify_one();
+        return lsn;
+    }
+
+    void CommitLoop() {
+        while (true) {
+            {
+                unique_lock<mutex> lock(mtx_);
+                pending_cv_.wait(lock, [&] { return !pending_.empty() || !open_; });
+                if (pending_.empty()) break; // closed and fully drained
+            }
+            // io_mtx_ is held from taking the batch until it is durable, so
+            // Rotate() cannot swap the file under a batch of the old epoch
+            lock_guard<mutex> io_lock(io_mtx_);
+            string batch;
+            uint64_t last;
+            {
+                lock_guard<mutex> lock(mtx_);
+                batch.swap(pending_);
+                last = appended_lsn_;
+            }
+            if (!batch.empty()) {
+                fwrite(batch.data(), 1, batch.size(), file_);
+                Sync(file_);
+            }
+            {
+                lock_guard<mutex> lock(mtx_);
+                durable_lsn_ = max(durable_lsn_, last);
+            }
+            durable_cv_.notify_all();
+        }
+        durable_cv_.notify_all();
+    }
+
+    mutable mutex mtx_;
+    mutex io_mtx_;
+    FILE* file_ = nullptr;
+    string path_;
+    string checkpoint_path_;
+    bool open_ = false;
+    atomic<bool> enabled_{false};
+    atomic<bool> synchronous_{true};
+    uint32_t epoch_ = 0;
+    string pending_;
+    uint64_t bytes_ = 0;
+    uint64_t checkpoint_bytes_ = kDefaultCheckpointBytes;
+    uint64_t next_checkpoint_ = kDefaultCheckpointBytes;
+    bool checkpoint_claimed_ = false;
+    uint64_t appended_lsn_ = 0;
+    uint64_t durable_lsn_ = 0;
+    uint64_t checkpoint_lsn_ = 0;
+    condition_variable pending_cv_;
+    condition_variable durable_cv_;
+    thread committer_;
+};
+
+const char WriteAheadLog::kMagic[9] = "BWAL0001";
+
+WriteAheadLog wal;
+
+// Sequence number of the last record this thread appended
+thread_local uint64_t wal_last_lsn = 0;
+
+// Log a state-changing operation to the trace and the write-ahead log
+void RecordOp(TraceOp op, int pid, const int* values, size_t count, int outcome) {
+    if (trace.Recording()) trace.Record(op, pid, values, count, outcome);
+    if (wal.Enabled()) {
+        uint64_t lsn = wal.Append(op, pid, values, count, outcome);
+        if (lsn != 0) wal_last_lsn = lsn;
+    }
+}
+
+// Declared ahead of the lock in every function that changes the state, so
+// its destructor runs after the lock is released: in synchronous mode it
+// waits until this thread's records are durable, and it runs a checkpoint
+// that came due.
+class WalCommit {
+public:
+    WalCommit() : start_(wal_last_lsn) {}
+    ~WalCommit();
+    WalCommit(const WalCommit&) = delete;
+    WalCommit& operator=(const WalCommit&) = delete;
+
+private:
+    uint64_t start_;
+};
+
+// Function prototypes
+void InitializeBlockchain();
+uint64_t CalculateHash(const Block& block);
+void AddBlock(const string& transaction);
+void VisualizeResourceGraph();
+void PredictiveAllocation();
+void HandleDeadlock();
+void StartSimulation();
+void StopSimulation();
+void SaveStateToFile(const string& filename);
+void LoadStateFromFile(const string& filename);
+void NetworkSync();
+void PerformanceMetrics();
+void GenerateSecurityReport();
+void DisplayResourceUtilizationTrends();
+void DisplayBlockchain();
+void AddProcess(int max_resources, int priority, const vector<int>& resources = {});
+void RemoveProcess(int pid);
+void RequestResources(int pid, const vector<int>& request);
+void ReleaseResources(int pid, const vector<int>& release);
+AdmissionOutcome TryRequest(int pid, const vector<int>& request);
+bool TryRelease(int pid, const vector<int>& release);
+int TryAddProcess(int max_resources, int priority, const vector<int>& resources = {}, int cpu_percent = -1);
+bool TryRemoveProcess(int pid);
+void BatchRequestMenu();
+void ConfigureLoadGenerator();
+void ConfigureHistory();
+void ConfigureAnalytics();
+void ConfigureDeadlockDetection();
+void ConfigureLogging();
+void FullChainVerification();
+void DetectDeadlockCycle();
+void ExportToText(const string& filename = "system_state.txt");
+void DisplayProcessStatus();
+void LoadConfigFromText(const string& filename);
+bool TryLoadConfigFromText(const string& filename);
+bool TryExportToText(const string& filename);
+bool TrySaveSnapshot(const string& filename, string& error);
+bool TryLoadSnapshot(const string& filename, string& error, uint32_t* wal_epoch = nullptr);
+void WriteStateText(ostream& out, bool include_history);
+void ReadStateText(const char* data, size_t size);
+void TraceStateSnapshot(SnapshotReason reason);
+void CheckpointReplacedState(SnapshotReason reason);
+bool TryCheckpoint(string& error);
+void TraceMenu();
+void ReplayTraceMenu();
+vector<int> FindDeadlockCycle();
+vector<vector<int>> FindDeadlockedSets(vector<int>* cycle = nullptr);
+vector<int> FindDeadlockedProcesses();
+vector<int> DeadlockedProcessesLocked();
+RecoveryReport TryRecoverDeadlock();
+bool TryPreempt(int pid, const vector<int>& amounts);
+void ConfigureDeadlockRecovery();
+void ConfigureWriteAheadLog();
+void ResetSystemState();
+void DisplaySimulationStats();
+void UpdatePriorityQueue();
+void DisplayPriorityQueue();
+void ValidateInput(int pid, const vector<int>& vec, const string& type);
+void InitializeSystem();
+
+// ======================== Core Banker's Algorithm Functions ========================
+
+// Reports print from a StateView, so they never hold mtx while printing
+void DisplayAllocationTable(const StateView& view) {
+    cout << "\n\t" << BOLD << "Allocation Table" << RESET;
+    cout << "\nProcess\t";
+    for (int i = 0; i < view.nresources; i++) {
+        cout << "R" << i << "\t";
+    }
+    cout << "Priority\tStatus";
+    cout << endl;
+
+    for (int i = 0; i < view.nprocesses; i++) {
+        cout << "P" << i << "\t";
+        for (int j = 0; j < view.nresources; j++) {
+            cout << view.allocation_matrix(i, j) << "\t";
+        }
+        cout << view.processes[i].priority << "\t" << (view.processes[i].status ? "Done" : "Active");
+        cout << endl;
+    }
+    LogAction("Display", "Allocation table displayed");
+}
+
+// Incremental safety engine. Rather than rescanning every process on every
+// pass, each resource keeps the active processes sorted by their Need for it,
+// and every process tracks how many resources still block it. When a process
+// finishes and returns its allocation, only the processes whose Need on one of
+// the grown resources just became satisfiable are touched. The ready worklist
+// reproduces the pass-by-pass order of the classic scan, so the resulting safe
+// sequence is identical. Run() first makes one plain pass in index order,
+// which settles most states on its own, and only sorts the processes that
+// pass leaves blocked.
+//
+// An optional delta (delta_pid, delta) is overlaid on the state as if it had
+// already been granted: Work starts at available - delta and the row of
+// delta_pid reads Need - delta / Allocation + delta. Nothing is written back.
+// The shape is taken from the rows passed in, so the engine runs on a
+// StateView as well as on the live state.
+struct SafetyEngine {
+    vector<vector<int>> need_order; // per resource: active processes sorted by Need
+    vector<size_t> cursor;          // per resource: prefix of need_order satisfied by work
+    vector<int> blocked;            // per process: resources whose Need still exceeds work
+    vector<char> finish;
+    vector<int> work;
+
+    // Sort the active processes of every resource by Need, or with
+    // only_unfinished just those not yet marked in finish. The orderings stay
+    // valid for any number of Check() calls as long as every row whose Need
+    // changes in between is passed to UpdateRow().
+    void Prepare(const vector<process>& processes, const ResourceMatrix& need_rows, bool only_unfinished = false) {
+        const int nprocesses = need_rows.rows(), nresources = need_rows.cols();
+        need_order.resize(nresources);
+        for (int j = 0; j < nresources; j++) {
+            vector<int>& order = need_order[j];
+            order.clear();
+            for (int i = 0; i < nprocesses; i++) {
+                if (!processes[i].status && !(only_unfinished && finish[i])) order.push_back(i);
+            }
+            sort(order.begin(), order.end(), [&](int a, int b) {
+                return need_rows(a, j) < need_rows(b, j);
+            });
+        }
+    }
+
+    // Move one process to its new place in every ordering after its Need row changed
+    void UpdateRow(int pid, const ResourceMatrix& need_rows) {
+        const int nresources = need_rows.cols();
+        for (int j = 0; j < nresources; j++) {
+            vector<int>& order = need_order[j];
+            auto it = find(order.begin(), order.end(), pid);
+            if (it == order.end()) continue;
+            order.erase(it);
+            auto pos = upper_bound(order.begin(), order.end(), need_rows(pid, j), [&](int value, int k) {
+                return value < need_rows(k, j);
+            });
+            order.insert(pos, pid);
+        }
+    }
+
+    // Safety check against the orderings built by the last Prepare()
+    bool Check(const vector<process>& processes, const ResourceMatrix& need_rows,
+               const ResourceMatrix& alloc_rows, const vector<int>& available, vector<int>& sequence,
+               int delta_pid = -1, const int* delta = nullptr) {
+        const int nprocesses = need_rows.rows(), nresources = need_rows.cols();
+        work = available;
+        if (delta_pid >= 0) {
+            for (int j = 0; j < nresources; j++) work[j] -= delta[j];
+        }
+        finish.assign(nprocesses, 0);
+        sequence.clear();
+        return Resume(processes, need_rows, alloc_rows, sequence, delta_pid, delta);
+    }
+
+    // Continue a check from the work, finish and sequence already in place,
+    // starting a new pass. The orderings must hold every active process not
+    // yet finished.
+    bool Resume(const vector<process>& processes, const ResourceMatrix& need_rows,
+                const ResourceMatrix& alloc_rows, vector<int>& sequence, int delta_pid, const int* delta) {
+        const int nprocesses = need_rows.rows(), nresources = need_rows.cols();
+        auto need = [&](int i, int j) {
+            return need_rows(i, j) - (i == delta_pid ? delta[j] : 0);
+        };
+        auto alloc = [&](int i, int j) {
+            return alloc_rows(i, j) + (i == delta_pid ? delta[j] : 0);
+        };
+        // The overlaid row is out of place in the orderings, so it is tracked
+        // on its own and skipped when the cursors pass it.
+        bool track_delta = delta_pid >= 0 && !processes[delta_pid].status && !finish[delta_pid];
+
+        blocked.assign(nprocesses, 0);
+        cursor.assign(nresources, 0);
+
+        int active = 0;
+        for (int i = 0; i < nprocesses; i++) {
+            if (!processes[i].status) active++;
+        }
+
+        // A process is blocked by every resource where its Need exceeds Work
+        for (int i = 0; i < nprocesses; i++) {
+            if (processes[i].status || finish[i]) continue;
+            if (i == delta_pid) {
+                for (int j = 0; j < nresources; j++) blocked[i] += need(i, j) > work[j];
+            } else {
+                blocked[i] = row_kernels.count_greater(need_rows.Row(i), work.data(), nresources);
+            }
+        }
+        for (int j = 0; j < nresources; j++) {
+            const vector<int>& order = need_order[j];
+            size_t& c = cursor[j];
+            while (c < order.size() && need_rows(order[c], j) <= work[j]) c++;
+        }
+
+        // "current" holds ready processes still reachable in this pass (index
+        // above the last one finished), "next" those the scan would only see
+        // on the following pass.
+        priority_queue<int, vector<int>, greater<int>> current, next;
+        for (int i = 0; i < nprocesses; i++) {
+            if (!processes[i].status && !finish[i] && blocked[i] == 0) current.push(i);
+        }
+
+        int pos = -1;
+        auto unblock = [&](int k) {
+            if (--blocked[k] == 0 && !finish[k]) {
+                if (k > pos) current.push(k);
+                else next.push(k);
+            }
+        };
+
+        while (true) {
+            if (current.empty()) {
+                if (next.empty()) break;
+                swap(current, next);
+                pos = -1;
+            }
+            int i = current.top();
+            current.pop();
+            finish[i] = 1;
+            sequence.push_back(i);
+            pos = i;
+
+            if (i == delta_pid) {
+                for (int j = 0; j < nresources; j++) work[j] += alloc(i, j);
+            } else {
+                row_kernels.add(work.data(), alloc_rows.Row(i), nresources);
+            }
+            for (int j = 0; j < nresources; j++) {
+                int a = alloc(i, j);
+                if (a == 0) continue;
+                if (track_delta && !finish[delta_pid]) {
+                    int n = need(delta_pid, j);
+                    if (n > work[j] - a && n <= work[j]) unblock(delta_pid);
+                }
+                const vector<int>& order = need_order[j];
+                size_t& c = cursor[j];
+                while (c < order.size() && need_rows(order[c], j) <= work[j]) {
+                    int k = order[c++];
+                    if (k != delta_pid) unblock(k);
+                }
+            }
+        }
+
+        return static_cast<int>(sequence.size()) == active;
+    }
+
+    bool Run(const vector<process>& processes, const ResourceMatrix& need_rows,
+             const ResourceMatrix& alloc_rows, const vector<int>& available, vector<int>& sequence,
+             int delta_pid = -1, const int* delta = nullptr) {
+        ScopedLatency timer(LatencyOp::SafetyCheck);
+        const int nprocesses = need_rows.rows(), nresources = need_rows.cols();
+        work = available;
+        if (delta_pid >= 0) {
+            for (int j = 0; j < nresources; j++) work[j] -= delta[j];
+        }
+        finish.assign(nprocesses, 0);
+        sequence.clear();
+
+        // First pass of the classic scan
+        int active = 0;
+        for (int i = 0; i < nprocesses; i++) {
+            if (processes[i].status) continue;
+            active++;
+            bool fits = true;
+            if (i == delta_pid) {
+                for (int j = 0; j < nresources && fits; j++) fits = need_rows(i, j) - delta[j] <= work[j];
+            } else {
+                fits = row_kernels.fits(need_rows.Row(i), work.data(), nresources);
+            }
+            if (!fits) continue;
+            finish[i] = 1;
+            sequence.push_back(i);
+            row_kernels.add(work.data(), alloc_rows.Row(i), nresources);
+            if (i == delta_pid) {
+                for (int j = 0; j < nresources; j++) work[j] += delta[j];
+            }
+        }
+        // Either everyone finished, or no one did and Work never grows
+        if (static_cast<int>(sequence.size()) == active || sequence.empty()) {
+            return static_cast<int>(sequence.size()) == active;
+        }
+
+        Prepare(processes, need_rows, true);
+        return Resume(processes, need_rows, alloc_rows, sequence, delta_pid, delta);
+    }
+};
+
+// Record a granted or released amount in the allocation history
+void RecordHistory(int pid, const vector<int>& amounts, HistoryAction action) {
+    lock_guard<mutex> lock(history_mtx);
+    history.Append(pid, action, amounts);
+    history_stats.Observe(amounts.data(), static_cast<int>(amounts.size()));
+}
+
+// One engine per thread so the menu and the simulation worker never share
+// scratch buffers, while repeated checks reuse their allocations.
+thread_local SafetyEngine safety_engine;
+
+// Safety check of the live state. The caller must hold mtx; releases running
+// under the shared lock restart the scan.
+bool IsSafe() {
+    bool safe = false;
+    ReadConsistent([&] {
+        safe = safety_engine.Run(processes, need_matrix, allocation_matrix, available, seq);
+    });
+    return safe;
+}
+
+// What-if view of a request on top of the live state. Evaluate() runs the
+// safety check with the request overlaid instead of copying the process
+// table; Commit() applies it in one step, and dropping the object without
+// committing discards it. The caller must hold mtx across both calls.
+class TentativeAllocation {
+public:
+    TentativeAllocation(int pid, const vector<int>& request) : pid_(pid), request_(request) {}
+
+    bool Evaluate() const {
+        return safety_engine.Run(processes, need_matrix, allocation_matrix, available, seq,
+                                 pid_, request_.data());
+    }
+
+    // Same as Evaluate(), reusing the need orderings already prepared in safety_engine
+    bool EvaluatePrepared() const {
+        ScopedLatency timer(LatencyOp::SafetyCheck);
+        return safety_engine.Check(processes, need_matrix, allocation_matrix, available, seq,
+                                   pid_, request_.data());
+    }
+
+    void Commit() const {
+        for (int j = 0; j < nresources; j++) {
+            available[j] -= request_[j];
+            allocation_matrix(pid_, j) += request_[j];
+            need_matrix(pid_, j) -= request_[j];
+        }
+        MarkRowWritten(pid_);
+    }
+
+private:
+    int pid_;
+    const vector<int>& request_;
+};
+
+// Multi-instance deadlock detection (Coffman, Elphick and Shoshani): the
+// Work/Finish reduction over the outstanding requests instead of the Need
+// rows. Processes holding nothing cannot be part of a deadlock and start
+// finished; any other process whose outstanding request fits in Work is
+// assumed to run to completion and return its allocation. Whatever remains
+// unfinished is exactly the set of deadlocked processes. Unlike a cycle in
+// the wait-for graph, this accounts for multiple instances per resource.
+//
+// Work only grows, so every process that fits in one pass can finish
+// together. The reduction runs such passes while each one still retires a
+// good share of the remaining processes, in parallel over chunks of them on
+// large tables; the rest runs on the incremental SafetyEngine with the
+// request rows in place of Need, which never rescans.
+struct DeadlockDetector {
+    static const int kParallelMinProcesses = 4096;
+
+    vector<process> view;  // status marks the processes already finished
+    vector<int> work;
+    vector<int> candidates;
+    vector<char> ready;
+    vector<int> sequence;
+    SafetyEngine engine;
+
+    // Deadlocked processes in ascending order. The caller must keep the
+    // state stable (mtx plus ReadConsistent(), or a StateView).
+    vector<int> Detect(const vector<process>& processes, const ResourceMatrix& request_rows,
+                       const ResourceMatrix& alloc_rows, const vector<int>& available, int threads) {
+        const int nprocesses = alloc_rows.rows(), nresources = alloc_rows.cols();
+        view = processes;
+        work = available;
+        candidates.clear();
+        for (int i = 0; i < nprocesses; i++) {
+            if (view[i].status) continue;
+            const int* alloc = alloc_rows.Row(i);
+            if (all_of(alloc, alloc + nresources, [](int a) { return a == 0; })) {
+                view[i].status = true;
+            } else {
+                candidates.push_back(i);
+            }
+        }
+
+        Passes(request_rows, alloc_rows, static_cast<int>(candidates.size()) >= kParallelMinProcesses ? threads : 1);
+        if (candidates.empty()) return {};
+
+        engine.Prepare(view, request_rows);
+        engine.Check(view, request_rows, alloc_rows, work, sequence);
+        vector<int> deadlocked;
+        for (int i : candidates) {
+            if (!view[i].status && !engine.finish[i]) deadlocked.push_back(i);
+        }
+        return deadlocked;
+    }
+
+private:
+    // Stops once a pass retires less than 1/16 of the remaining processes
+    void Passes(const ResourceMatrix& request_rows, const ResourceMatrix& alloc_rows, int threads) {
+        const int nprocesses = alloc_rows.rows(), nresources = alloc_rows.cols();
+        ready.assign(nprocesses, 0);
+        vector<vector<int>> deltas(threads, vector<int>(nresources));
+        while (!candidates.empty()) {
+            int per_thread = (static_cast<int>(candidates.size()) + threads - 1) / threads;
+            auto scan = [&](int t) {
+                vector<int>& delta = deltas[t];
+                fill(delta.begin(), delta.end(), 0);
+                size_t begin = static_cast<size_t>(t) * per_thread;
+                size_t end = min(candidates.size(), begin + per_thread);
+                for (size_t k = begin; k < end; k++) {
+                    int i = candidates[k];
+                    if (row_kernels.fits(request_rows.Row(i), work.data(), nresources)) {
+                        ready[i] = 1;
+                        row_kernels.add(delta.data(), alloc_rows.Row(i), nresources);
+                    }
+                }
+            };
+            if (threads == 1) {
+                scan(0);
+            } else {
+                vector<thread> workers;
+                for (int t = 0; t < threads; t++) workers.emplace_back(scan, t);
+                for (thread& worker : workers) worker.join();
+            }
+
+            size_t remaining = 0;
+            for (int i : candidates) {
+                if (ready[i]) {
+                    view[i].status = true;
+                } else {
+                    candidates[remaining++] = i;
+                }
+            }
+            size_t retired = candidates.size() - remaining;
+            candidates.resize(remaining);
+            for (const vector<int>& delta : deltas) row_kernels.add(work.data(), delta.data(), nresources);
+            if (retired == 0 || retired * 16 < remaining) break;
+        }
+    }
+};
+
+thread_local DeadlockDetector deadlock_detector;
+
+// Detector behind option 21: the multi-instance reduction, or cycles in the
+// wait-for graph (which also flags waits that other processes can resolve)
+enum class DetectionMode { MultiInstance, WaitForGraph };
+DetectionMode detection_mode = DetectionMode::MultiInstance;
+
+// ======================== Deadlock Recovery ========================
+// Recovery works on the set reported by the multi-instance detector. Every
+// process outside that set can finish, so the deadlocked processes form a
+// problem of their own whose work starts as available plus the allocations
+// of all the others. The planner takes resources back until the reduction
+// of that problem retires every process, picking the cheapest action each
+// time; the plan is then applied to the real state and the detector runs
+// again until nothing is deadlocked.
+//
+// Preemption takes back only the units some waiting process is short of.
+// They return to the victim's need and outstanding request, so the victim
+// rolls back that far and retries later instead of losing all its work.
+// Termination releases everything the victim holds; with few deadlocked
+// processes the planner searches every victim set for the cheapest one.
+enum class RecoveryMode { Preempt, Terminate };
+
+// Relative weight of each factor in the cost of an action against a victim
+struct RecoveryWeights {
+    double priority;  // per priority level above the lowest (5)
+    double held;      // per unit taken back
+    double cpu;       // scales the units by cpu_usage, the work a rollback loses
+    double wait;      // per unit of wait_time, so the same victim is not picked forever
+};
+
+RecoveryMode recovery_mode = RecoveryMode::Preempt;
+RecoveryWeights recovery_weights = {1.0, 1.0, 1.0, 0.5};
+
+class RecoveryPlanner {
+public:
+    static const int kExactSearchMax = 12;    // terminate: exhaustive victim search up to this many processes
+    static const int kMaxBeneficiaries = 64;  // preempt: waiting processes considered per step
+    static constexpr double kTerminationPenalty = 10.0;  // work lost by a termination beyond the units held
+
+    static double PreemptCost(const process& p, long long units, const RecoveryWeights& w) {
+        return Importance(p, w) * w.held * units + w.wait * p.wait_time;
+    }
+
+    static double TerminateCost(const process& p, long long held, const RecoveryWeights& w) {
+        return Importance(p, w) * (w.held * held + kTerminationPenalty) + w.wait * p.wait_time;
+    }
+
+    // Actions that leave none of the deadlocked processes deadlocked. The
+    // caller must hold mtx exclusively.
+    vector<RecoveryAction> Plan(const vector<int>& deadlocked, RecoveryMode mode, const RecoveryWeights& w) {
+        Load(deadlocked);
+        vector<RecoveryAction> actions;
+        if (mode == RecoveryMode::Preempt) {
+            PlanPreemption(w, actions);
+        } else {
+            PlanTermination(w, actions);
+        }
+        return actions;
+    }
+
+private:
+    static double Importance(const process& p, const RecoveryWeights& w) {
+        int levels = 5 - min(5, max(1, p.priority));
+        return (1 + w.priority * levels) * (1 + w.cpu * p.cpu_usage);
+    }
+
+    int* Alloc(int k) { return &alloc_[static_cast<size_t>(k) * nresources]; }
+    int* Request(int k) { return &request_[static_cast<size_t>(k) * nresources]; }
+
+    void Load(const vector<int>& deadlocked) {
+        members_ = deadlocked;
+        int count = static_cast<int>(members_.size());
+        base_ = available;
+        vector<char> member(nprocesses, 0);
+        for (int pid : members_) member[pid] = 1;
+        for (int i = 0; i < nprocesses; i++) {
+            if (!processes[i].status && !member[i]) row_kernels.add(base_.data(), allocation_matrix.Row(i), nresources);
+        }
+        alloc_.resize(static_cast<size_t>(count) * nresources);
+        request_.resize(alloc_.size());
+        for (int k = 0; k < count; k++) {
+            copy_n(allocation_matrix.Row(members_[k]), nresources, Alloc(k));
+            copy_n(request_matrix.Row(members_[k]), nresources, Request(k));
+        }
+        gone_.assign(count, 0);
+    }
+
+    // Reduction of the sub-problem: fills unfinished_ and leaves the work
+    // available once every other member has finished in work_
+    void Reduce() {
+        int count = static_cast<int>(members_.size());
+        work_ = base_;
+        done_.assign(count, 0);
+        for (int k = 0; k < count; k++) {
+            const int* alloc = Alloc(k);
+            done_[k] = gone_[k] || all_of(alloc, alloc + nresources, [](int a) { return a == 0; });
+        }
+        bool progress = true;
+        while (progress) {
+            progress = false;
+            for (int k = 0; k < count; k++) {
+                if (done_[k] || !row_kernels.fits(Request(k), work_.data(), nresources)) continue;
+                row_kernels.add(work_.data(), Alloc(k), nresources);
+                done_[k] = 1;
+                progress = true;
+            }
+        }
+        unfinished_.clear();
+        for (int k = 0; k < count; k++) {
+            if (!done_[k]) unfinished_.push_back(k);
+        }
+    }
+
+    // Greedy: each step takes, from a single victim, the cheapest amount
+    // that unblocks some waiting process, or rolls one victim back entirely
+    // when no single victim can cover any process's shortfall
+    void PlanPreemption(const RecoveryWeights& w, vector<RecoveryAction>& actions) {
+        vector<int> slot(members_.size(), -1);  // index of each member's action
+        vector<pair<long long, int>> shortfalls;
+        vector<int> deficit(nresources), take(nresources);
+        for (Reduce(); !unfinished_.empty(); Reduce()) {
+            shortfalls.clear();
+            for (int u : unfinished_) {
+                long long total = 0;
+                for (int j = 0; j < nresources; j++) total += max(0, Request(u)[j] - work_[j]);
+                shortfalls.emplace_back(total, u);
+            }
+            size_t beneficiaries = min(shortfalls.size(), static_cast<size_t>(kMaxBeneficiaries));
+            partial_sort(shortfalls.begin(), shortfalls.begin() + beneficiaries, shortfalls.end());
+
+            double best_cost = numeric_limits<double>::infinity();
+            int victim = -1;
+            for (size_t b = 0; b < beneficiaries; b++) {
+                int u = shortfalls[b].second;
+                for (int j = 0; j < nresources; j++) deficit[j] = max(0, Request(u)[j] - work_[j]);
+                for (int v : unfinished_) {
+                    if (v == u || !row_kernels.fits(deficit.data(), Alloc(v), nresources)) continue;
+                    double cost = PreemptCost(processes[members_[v]], shortfalls[b].first, w);
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        victim = v;
+                        take = deficit;
+                    }
+                }
+            }
+            for (int v : unfinished_) {
+                long long held = accumulate(Alloc(v), Alloc(v) + nresources, 0LL);
+                double cost = PreemptCost(processes[members_[v]], held, w);
+                if (cost < best_cost) {
+                    best_cost = cost;
+                    victim = v;
+                    take.assign(Alloc(v), Alloc(v) + nresources);
+                }
+            }
+
+            for (int j = 0; j < nresources; j++) {
+                Alloc(victim)[j] -= take[j];
+                Request(victim)[j] += take[j];
+                base_[j] += take[j];
+            }
+            if (slot[victim] < 0) {
+                slot[victim] = static_cast<int>(actions.size());
+                actions.push_back({members_[victim], false, vector<int>(nresources, 0), 0.0});
+            }
+            RecoveryAction& action = actions[slot[victim]];
+            row_kernels.add(action.amounts.data(), take.data(), nresources);
+            action.cost += best_cost;
+        }
+    }
+
+    // Cheapest set of victims whose termination ends the deadlock: every
+    // subset of the deadlocked processes when there are few, otherwise the
+    // cheapest victim at a time until the reduction completes
+    void PlanTermination(const RecoveryWeights& w, vector<RecoveryAction>& actions) {
+        Reduce();
+        vector<int> candidates = unfinished_;
+        int count = static_cast<int>(candidates.size());
+        vector<double> cost(count);
+        for (int c = 0; c < count; c++) {
+            int k = candidates[c];
+            cost[c] = TerminateCost(processes[members_[k]], accumulate(Alloc(k), Alloc(k) + nresources, 0LL), w);
+        }
+
+        vector<int> victims;
+        if (count <= kExactSearchMax) {
+            double best_cost = numeric_limits<double>::infinity();
+            uint32_t best_mask = 0;
+            for (uint32_t mask = 1; mask < (1u << count); mask++) {
+                double total = 0;
+                for (int c = 0; c < count; c++) {
+                    if (mask & (1u << c)) total += cost[c];
+                }
+                if (total >= best_cost) continue;
+                SetTerminated(candidates, mask);
+                Reduce();
+                if (unfinished_.empty()) {
+                    best_cost = total;
+                    best_mask = mask;
+                }
+                SetTerminated(candidates, 0);
+            }
+            for (int c = 0; c < count; c++) {
+                if (best_mask & (1u << c)) victims.push_back(candidates[c]);
+            }
+        } else {
+            for (; !unfinished_.empty(); Reduce()) {
+                int victim = unfinished_[0];
+                double victim_cost = numeric_limits<double>::infinity();
+                for (int k : unfinished_) {
+                    int c = static_cast<int>(lower_bound(candidates.begin(), candidates.end(), k) - candidates.begin());
+                    if (cost[c] < victim_cost) {
+                        victim_cost = cost[c];
+                        victim = k;
+                    }
+                }
+                gone_[victim] = 1;
+                row_kernels.add(base_.data(), Alloc(victim), nresources);
+                victims.push_back(victim);
+            }
+        }
+
+        for (int k : victims) {
+            int c = static_cast<int>(lower_bound(candidates.begin(), candidates.end(), k) - candidates.begin());
+            actions.push_back({members_[k], true, vector<int>(Alloc(k), Alloc(k) + nresources), cost[c]});
+        }
+    }
+
+    // Marks the candidates in mask terminated, moving their allocation to the base work
+    void SetTerminated(const vector<int>& candidates, uint32_t mask) {
+        for (size_t c = 0; c < candidates.size(); c++) {
+            int k = candidates[c];
+            bool terminated = mask & (1u << c);
+            if (terminated == static_cast<bool>(gone_[k])) continue;
+            gone_[k] = terminated;
+            for (int j = 0; j < nresources; j++) base_[j] += terminated ? Alloc(k)[j] : -Alloc(k)[j];
+        }
+    }
+
+    vector<int> members_;     // pids of the deadlocked processes
+    vector<int> base_;        // work before any member finishes
+    vector<int> alloc_;       // member rows, as planned so far
+    vector<int> request_;
+    vector<char> gone_;       // terminated in the plan
+    vector<char> done_;
+    vector<int> work_;
+    vector<int> unfinished_;  // member indices, ascending
+};
+
+RecoveryPlanner recovery_planner;
+
+// ======================== Enhanced Features ========================
+
+// ======================== Chain Verification ========================
+// Audits verify the chain incrementally: every block below the watermark has
+// already had its hash and link checked, so only blocks appended since the
+// last audit are re-hashed. Every kCheckpointStride blocks the hashes of the
+// segment are folded into a checkpoint digest (the leaves of a two-level
+// Merkle tree whose root is Root()). A full verification recomputes all
+// segments in parallel and compares them to the checkpoints, which also
+// catches blocks rewritten after they were first verified.
+class ChainVerifier {
+public:
+    static constexpr int kCheckpointStride = 4096;
+
+    ChainVerifier() { Reset(); }
+
+    void Reset() {
+        verified_upto_ = 0;
+        last_hash_ = 0;
+        segment_ = BlockHasher();
+        checkpoints_.clear();
+    }
+
+    int VerifiedUpto() const { return verified_upto_; }
+    size_t CheckpointCount() const { return checkpoints_.size(); }
+
+    uint64_t Root() const {
+        BlockHasher root;
+        root.Update(checkpoints_.data(), checkpoints_.size() * sizeof(uint64_t));
+        return root.Final();
+    }
+
+    // Verify blocks [watermark, length). On failure the watermark stays at
+    // the first bad block, so the next audit reports it again.
+    bool VerifyNew(int length, int& checked) {
+        checked = 0;
+        vector<Block> page;
+        for (int start = verified_upto_; start < length; start += kCheckpointStride) {
+            if (!LoadBlocks(start, min(kCheckpointStride, length - start), page)) return false;
+            for (const Block& block : page) {
+                if (!BlockValid(block, verified_upto_, last_hash_)) return false;
+                Accept(block);
+                checked++;
+            }
+        }
+        return true;
+    }
+
+    // Re-verify blocks [0, length) on up to `threads` threads, each checking
+    // a contiguous run of segments including the link into its first block.
+    // On success the watermark and checkpoints are rebuilt from the result;
+    // on failure first_bad is the lowest offending block index.
+    bool VerifyFull(int length, int threads, int& first_bad) {
+        int segments = (length + kCheckpointStride - 1) / kCheckpointStride;
+        threads = max(1, min(threads, segments));
+        int per_thread = segments > 0 ? (segments + threads - 1) / threads : 0;
+        vector<BlockHasher> folds(segments);
+        vector<int> bad(threads, INT_MAX);
+        uint64_t tail_hash = 0;
+
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                int seg_begin = t * per_thread;
+                int seg_end = min(segments, seg_begin + per_thread);
+                vector<Block> page;
+                uint64_t previous_hash = 0;
+                if (seg_begin < seg_end && seg_begin > 0) {
+                    if (!LoadBlocks(seg_begin * kCheckpointStride - 1, 1, page)) {
+                        bad[t] = seg_begin * kCheckpointStride;
+                        return;
+                    }
+                    previous_hash = page[0].hash;
+                }
+                for (int seg = seg_begin; seg < seg_end; seg++) {
+                    int begin = seg * kCheckpointStride;
+                    int end = min(length, begin + kCheckpointStride);
+                    if (!LoadBlocks(begin, end - begin, page)) {
+                        bad[t] = begin;
+                        return;
+                    }
+                    for (int k = 0; k < end - begin; k++) {
+                        if (!BlockValid(page[k], begin + k, previous_hash)) {
+                            bad[t] = begin + k;
+                            return;
+                        }
+                        folds[seg].Update(&page[k].hash, sizeof(page[k].hash));
+                        previous_hash = page[k].hash;
+                    }
+                    if (end == length) tail_hash = previous_hash;
+                }
+            });
+        }
+        for (thread& worker : workers) worker.join();
+
+        first_bad = *min_element(bad.begin(), bad.end());
+        if (first_bad != INT_MAX) return false;
+        for (size_t k = 0; k < checkpoints_.size() && k < folds.size(); k++) {
+            if (folds[k].Final() != checkpoints_[k]) {
+                first_bad = static_cast<int>(k) * kCheckpointStride;
+                return false;
+            }
+        }
+
+        checkpoints_.clear();
+        segment_ = BlockHasher();
+        for (int seg = 0; seg < segments; seg++) {
+            if ((seg + 1) * kCheckpointStride <= length) checkpoints_.push_back(folds[seg].Final());
+            else segment_ = folds[seg];
+        }
+        verified_upto_ = length;
+        last_hash_ = tail_hash;
+        return true;
+    }
+
+private:
+    static bool BlockValid(const Block& block, int expected_index, uint64_t previous_hash) {
+        if (block.index != expected_index) return false;
+        return block.index == 0 || (block.previous_hash == previous_hash && block.hash == CalculateHash(block));
+    }
+
+    void Accept(const Block& block) {
+        segment_.Update(&block.hash, sizeof(block.hash));
+        last_hash_ = block.hash;
+        verified_upto_ = block.index + 1;
+        if (verified_upto_ % kCheckpointStride == 0) {
+            checkpoints_.push_back(segment_.Final());
+            segment_ = BlockHasher();
+        }
+    }
+
+    int verified_upto_;
+    uint64_t last_hash_;
+    BlockHasher segment_;           // fold of the current, incomplete segment
+    vector<uint64_t> checkpoints_;  // one digest per complete segment
+};
+
+ChainVerifier chain_verifier;
+
+void InitializeBlockchain() {
+    Block genesis;
+    genesis.index = 0;
+    genesis.timestamp = time(nullptr);
+    genesis.transaction = "Genesis Block";
+    genesis.previous_hash = 0;
+    genesis.hash = CalculateHash(genesis);
+    lock_guard<mutex> lock(chain_mtx);
+    blockchain.clear();
+    blockchain.push_back(genesis);
+    chain_length = 1;
+    chain_verifier.Reset();
+    if (!ledger.Open("blockchain.ledger")) {
+        LogMessage(LogLevel::Error, "Blockchain", "Failed to open blockchain.ledger");
+    }
+    ledger.Append(genesis);
+    LogAction("Blockchain", "Initialized with genesis block");
+}
+
+uint64_t CalculateHash(const Block& block) {
+    int32_t index = block.index;
+    int64_t timestamp = block.timestamp;
+    BlockHasher hasher;
+    hasher.Update(&index, sizeof(index));
+    hasher.Update(&timestamp, sizeof(timestamp));
+    hasher.Update(block.transaction.data(), block.transaction.size());
+    hasher.Update(&block.previous_hash, sizeof(block.previous_hash));
+    return hasher.Final();
+}
+
+void AddBlock(const string& transaction) {
+    ScopedLatency timer(LatencyOp::BlockAppend);
+    unique_lock<mutex> lock(chain_mtx);
+    Block newBlock;
+    newBlock.index = chain_length;
+    newBlock.timestamp = time(nullptr);
+    newBlock.transaction = transaction;
+    newBlock.previous_hash = blockchain.back().hash;
+    newBlock.hash = CalculateHash(newBlock);
+    ledger.Append(newBlock);
+    blockchain.push_back(newBlock);
+    chain_length++;
+    if (blockchain.size() > kChainWindow) blockchain.pop_front();
+    lock.unlock();
+    LogAction("Blockchain", "Added block with transaction: " + transaction);
+}
+
+void VisualizeResourceGraph() {
+    shared_ptr<const StateView> view = state_views.Acquire(banker);
+    const int n = view->nprocesses, m = view->nresources;
+    cout << "\n" << BOLD << CYAN << "Resource Allocation Graph:" << RESET << endl;
+    cout << "Processes: ";
+    for (int i = 0; i < n; i++) {
+        cout << "P" << i << " ";
+    }
+    cout << "\nResources: ";
+    for (int i = 0; i < m; i++) {
+        cout << "R" << i << "(" << view->available[i] << ") ";
+    }
+    cout << "\n\nAllocations:\n";
+
+    for (int i = 0; i < n; i++) {
+        cout << "P" << i << " -> ";
+        for (int j = 0; j < m; j++) {
+            if (view->allocation_matrix(i, j) > 0) {
+                cout << "R" << j << "(" << view->allocation_matrix(i, j) << ") ";
+            }
+        }
+        cout << endl;
+    }
+
+    cout << "\nRequests:\n";
+    for (int i = 0; i < n; i++) {
+        cout << "P" << i << " needs: ";
+        for (int j = 0; j < m; j++) {
+            if (view->need_matrix(i, j) > 0) {
+                cout << "R" << j << "(" << view->need_matrix(i, j) << ") ";
+            }
+        }
+        cout << endl;
+    }
+
+    // Outstanding requests that do not fit; only the reduction decides
+    // whether the waits can ever be satisfied
+    bool waiting = false;
+    for (int i = 0; i < n; i++) {
+        if (view->processes[i].status) continue;
+        const int* request = view->request_matrix.Row(i);
+        if (row_kernels.count_greater(request, view->available.data(), m) == 0) continue;
+        for (int j = 0; j < m; j++) {
+            if (request[j] > view->available[j]) {
+                cout << YELLOW << "! P" << i << " is waiting for R" << j << RESET << endl;
+                waiting = true;
+            }
+        }
+    }
+
+    vector<int> deadlocked = deadlock_detector.Detect(view->processes, view->request_matrix, view->allocation_matrix,
+                                                      view->available, max(1u, thread::hardware_concurrency()));
+    if (!deadlocked.empty()) {
+        cout << RED << "\nDeadlock detected: ";
+        for (size_t i = 0; i < deadlocked.size(); i++) cout << (i ? ", " : "") << "P" << deadlocked[i];
+        cout << RESET << endl;
+        sim_stats.deadlocks_detected++;
+    } else if (waiting) {
+        cout << GREEN << "\nWaiting processes can still be satisfied; no deadlock" << RESET << endl;
+    } else {
+        cout << GREEN << "\nNo immediate deadlock detected" << RESET << endl;
+    }
+    LogAction("Graph", "Resource allocation graph displayed");
+}
+
+void PredictiveAllocation() {
+    cout << "\n" << BOLD << MAGENTA << "Predictive Resource Allocation:" << RESET << endl;
+    shared_lock<shared_mutex> lock(mtx);
+    lock_guard<mutex> history_lock(history_mtx);
+
+    if (history_stats.Observed() < 10) {
+        cout << "Insufficient data for prediction (need at least 10 history records)" << endl;
+        return;
+    }
+
+    vector<double> avg_increase(nresources, 0.0);
+    for (int j = 0; j < nresources; j++) avg_increase[j] = history_stats.IncreaseMean(j);
+
+    cout << "Predicted resource requests in next cycle:\n";
+    for (int j = 0; j < nresources; j++) {
+        cout << "R" << j << ": " << fixed << setprecision(2) << avg_increase[j] << "\t";
+    }
+    cout << endl;
+    cout << "Recent trend (EWMA, alpha " << setprecision(2) << history_stats.Alpha() << "):\n";
+    for (int j = 0; j < nresources; j++) {
+        cout << "R" << j << ": " << history_stats.IncreaseEwma(j) << "\t";
+    }
+    cout << endl;
+
+    // Releases add to available under the shared lock, so it is read atomically
+    vector<int> free_units(nresources);
+    for (int j = 0; j < nresources; j++) free_units[j] = AtomicLoad(available[j]);
+
+    cout << "\nAllocation strategy suggestion:\n";
+    for (int j = 0; j < nresources; j++) {
+        if (avg_increase[j] > free_units[j]) {
+            cout << RED << "Warning: R" << j << " may be insufficient (Need: " 
+                 << avg_increase[j] << ", Available: " << free_units[j] << ")" << RESET << endl;
+        } else if (avg_increase[j] > free_units[j] * 0.7) {
+            cout << YELLOW << "Monitor R" << j << " closely (Need: " 
+                 << avg_increase[j] << ", Available: " << free_units[j] << ")" << RESET << endl;
+        } else {
+            cout << GREEN << "R" << j << " is sufficient (Need: " 
+                 << avg_increase[j] << ", Available: " << free_units[j] << ")" << RESET << endl;
+        }
+    }
+    LogAction("Prediction", "Predictive allocation analyzed");
+}
+
+// Takes amounts back from an active process: they return to its need and to
+// its outstanding request, which it retries once the deadlock is gone. The
+// caller must hold mtx exclusively.
+void PreemptLocked(int pid, const vector<int>& amounts) {
+    for (int j = 0; j < nresources; j++) {
+        allocation_matrix(pid, j) -= amounts[j];
+        need_matrix(pid, j) += amounts[j];
+        request_matrix(pid, j) += amounts[j];
+        available[j] += amounts[j];
+    }
+    processes[pid].wait_time++;
+    MarkRowWritten(pid);
+    RecordOp(TraceOp::Preempt, pid, amounts.data(), amounts.size(), 1);
+
+    string units;
+    for (int a : amounts) units += " " + to_string(a);
+    AddBlock("Deadlock resolution: Preempted" + units + " from P" + to_string(pid));
+    LogAction("Deadlock", "Preempted" + units + " from P" + to_string(pid));
+}
+
+// The caller must hold mtx exclusively
+void TerminateLocked(int pid) {
+    partitions.RemoveProcess(pid);
+    for (int j = 0; j < nresources; j++) {
+        available[j] += allocation_matrix(pid, j);
+        allocation_matrix(pid, j) = 0;
+        need_matrix(pid, j) = 0;
+        request_matrix(pid, j) = 0;
+    }
+    processes[pid].status = true;
+    processes[pid].end_time = time(nullptr);
+    MarkRowWritten(pid);
+    RecordOp(TraceOp::RemoveProcess, pid, nullptr, 0, 1);
+
+    AddBlock("Deadlock resolution: Terminated P" + to_string(pid));
+    LogAction("Deadlock", "Terminated P" + to_string(pid));
+}
+
+bool TryPreempt(int pid, const vector<int>& amounts) {
+    WalCommit commit;
+    unique_lock<shared_mutex> lock(mtx);
+    bool valid = pid >= 0 && pid < nprocesses && !processes[pid].status &&
+                 amounts.size() == static_cast<size_t>(nresources);
+    for (int j = 0; valid && j < nresources; j++) {
+        valid = amounts[j] >= 0 && amounts[j] <= allocation_matrix(pid, j);
+    }
+    if (!valid) {
+        RecordOp(TraceOp::Preempt, pid, amounts.data(), amounts.size(), 0);
+        return false;
+    }
+    PreemptLocked(pid, amounts);
+    return true;
+}
+
+// Plans and applies recovery until the detector finds no deadlocked
+// process. One round normally suffices, since the plan resolves the
+// deadlocked processes with everything else assumed to finish; the rounds
+// only guard against a plan that falls short.
+RecoveryReport TryRecoverDeadlock() {
+    const int kMaxRounds = 8;
+    WalCommit commit;
+    unique_lock<shared_mutex> lock(mtx);
+    RecoveryReport report;
+    report.deadlocked = DeadlockedProcessesLocked();
+    report.rounds = 0;
+    vector<int> deadlocked = report.deadlocked;
+    while (!deadlocked.empty() && report.rounds < kMaxRounds) {
+        report.rounds++;
+        for (RecoveryAction& action : recovery_planner.Plan(deadlocked, recovery_mode, recovery_weights)) {
+            if (action.terminate) {
+                TerminateLocked(action.pid);
+            } else {
+                PreemptLocked(action.pid, action.amounts);
+            }
+            report.actions.push_back(move(action));
+        }
+        deadlocked = DeadlockedProcessesLocked();
+    }
+    report.resolved = deadlocked.empty();
+    if (!report.deadlocked.empty() && report.resolved) sim_stats.deadlocks_resolved++;
+    return report;
+}
+
+void HandleDeadlock() {
+    cout << "\n" << BOLD << RED << "Deadlock Handling Mechanism" << RESET << endl;
+    RecoveryReport report = TryRecoverDeadlock();
+    if (report.deadlocked.empty()) {
+        cout << GREEN << "No deadlocked processes; nothing to recover" << RESET << endl;
+        return;
+    }
+
+    cout << "Deadlocked processes: ";
+    for (size_t i = 0; i < report.deadlocked.size(); i++) cout << (i ? ", " : "") << "P" << report.deadlocked[i];
+    cout << endl;
+    double total = 0;
+    for (const RecoveryAction& action : report.actions) {
+        if (action.terminate) {
+            cout << "Terminated P" << action.pid << ", releasing";
+        } else {
+            cout << "Preempted from P" << action.pid << ":";
+        }
+        for (int a : action.amounts) cout << " " << a;
+        cout << " (cost " << fixed << setprecision(2) << action.cost << ")" << endl;
+        total += action.cost;
+    }
+    cout << "Total cost " << fixed << setprecision(2) << total << " over " << report.rounds << " round(s)" << endl;
+    if (report.resolved) {
+        cout << GREEN << "System is deadlock-free" << RESET << endl;
+    } else {
+        cout << RED << "Deadlock persists after " << report.rounds << " rounds" << RESET << endl;
+    }
+}
+
+// Load generator. Worker threads drive a weighted mix of requests, releases
+// and process churn through the quiet Try* paths, each with its own RNG and
+// its own cache line of counters, and print nothing while running.
+// Closed loop issues the next operation as soon as the previous one returns;
+// open loop issues on a fixed schedule at target_rate across all threads and
+// counts operations that start behind schedule. Removes stop while half of
+// max_processes or fewer are active, so churn never drains the table.
+struct LoadProfile {
+    int threads;
+    bool open_loop;
+    double target_rate;    // ops/s across all threads (open loop only)
+    int request_weight;
+    int release_weight;
+    int add_weight;
+    int remove_weight;
+    int max_processes;     // adds stop once the process table reaches this size
+};
+
+LoadProfile load_profile = {4, false, 50000.0, 60, 30, 5, 5, 256};
+
+struct LoadTotals {
+    uint64_t ops;
+    uint64_t granted;
+    uint64_t denied_unsafe;
+    uint64_t denied_other;
+    uint64_t released;
+    uint64_t added;
+    uint64_t removed;
+    uint64_t skipped;
+    uint64_t late;
+    double seconds;
+};
+
+class LoadGenerator {
+public:
+    ~LoadGenerator() { Stop(); }
+
+    bool Start(const LoadProfile& profile) {
+        if (running_) return false;
+        profile_ = profile;
+        profile_.threads = max(1, profile_.threads);
+        counters_.reset(new WorkerCounters[profile_.threads]);
+        started_ = chrono::steady_clock::now();
+        running_ = true;
+        uint32_t seed = static_cast<uint32_t>(chrono::steady_clock::now().time_since_epoch().count());
+        for (int t = 0; t < profile_.threads; t++) {
+            workers_.emplace_back(&LoadGenerator::Worker, this, t, seed + 0x9E3779B9u * t);
+        }
+        return true;
+    }
+
+    // Stop the workers, wait for them and return the final totals
+    LoadTotals Stop() {
+        running_ = false;
+        for (auto& worker : workers_) worker.join();
+        workers_.clear();
+        if (!counters_) return LoadTotals();
+        stopped_ = chrono::steady_clock::now();
+        return Totals();
+    }
+
+    bool Running() const { return running_; }
+
+    LoadTotals Totals() const {
+        LoadTotals totals = {};
+        if (!counters_) return totals;
+        for (int t = 0; t < profile_.threads; t++) {
+            const WorkerCounters& c = counters_[t];
+            totals.granted += c.granted.load(memory_order_relaxed);
+            totals.denied_unsafe += c.denied_unsafe.load(memory_order_relaxed);
+            totals.denied_other += c.denied_other.load(memory_order_relaxed);
+            totals.released += c.released.load(memory_order_relaxed);
+            totals.added += c.added.load(memory_order_relaxed);
+            totals.removed += c.removed.load(memory_order_relaxed);
+            totals.skipped += c.skipped.load(memory_order_relaxed);
+            totals.late += c.late.load(memory_order_relaxed);
+        }
+        totals.ops = totals.granted + totals.denied_unsafe + totals.denied_other + totals.released +
+                     totals.added + totals.removed + totals.skipped;
+        auto end = running_ ? chrono::steady_clock::now() : stopped_;
+        totals.seconds = chrono::duration<double>(end - started_).count();
+        return totals;
+    }
+
+private:
+    struct alignas(64) WorkerCounters {
+        atomic<uint64_t> granted{0};
+        atomic<uint64_t> denied_unsafe{0};
+        atomic<uint64_t> denied_other{0};
+        atomic<uint64_t> released{0};
+        atomic<uint64_t> added{0};
+        atomic<uint64_t> removed{0};
+        atomic<uint64_t> skipped{0};
+        atomic<uint64_t> late{0};
+    };
+
+    static void Bump(atomic<uint64_t>& counter) {
+        counter.store(counter.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+
+    // Pick a random active process and copy its Need and Allocation rows and
+    // the free units. Returns false if a few picks all hit finished processes.
+    static bool SampleProcess(mt19937& rng, int& pid, vector<int>& need, vector<int>& alloc,
+                              vector<int>& free_units) {
+        shared_lock<shared_mutex> lock(mtx);
+        if (nprocesses == 0) return false;
+        int tries = 4;
+        do {
+            pid = static_cast<int>(rng() % nprocesses);
+        } while (processes[pid].status && --tries > 0);
+        if (processes[pid].status) return false;
+        lock_guard<mutex> row_lock(release_stripes[pid % kReleaseStripes]);
+        need.assign(need_matrix.Row(pid), need_matrix.Row(pid) + nresources);
+        alloc.assign(allocation_matrix.Row(pid), allocation_matrix.Row(pid) + nresources);
+        free_units.resize(nresources);
+        for (int j = 0; j < nresources; j++) free_units[j] = AtomicLoad(available[j]);
+        return true;
+    }
+
+    // Resource types of a random partition for an added process, none (all
+    // types) while the resources are not partitioned
+    static vector<int> PickPartition(mt19937& rng) {
+        shared_lock<shared_mutex> lock(mtx);
+        if (partitions.Count() == 0) return {};
+        return partitions.Resources(static_cast<int>(rng() % partitions.Count()));
+    }
+
+    static void CountProcesses(int& total, int& active) {
+        shared_lock<shared_mutex> lock(mtx);
+        total = nprocesses;
+        active = static_cast<int>(count_if(processes.begin(), processes.end(),
+                                           [](const process& p) { return !p.status; }));
+    }
+
+    void Worker(int id, uint32_t seed) {
+        mt19937 rng(seed);
+        WorkerCounters& c = counters_[id];
+        const int total_weight = max(1, profile_.request_weight + profile_.release_weight +
+                                        profile_.add_weight + profile_.remove_weight);
+        chrono::nanoseconds interval(0);
+        if (profile_.open_loop && profile_.target_rate > 0) {
+            interval = chrono::nanoseconds(static_cast<int64_t>(1e9 * profile_.threads / profile_.target_rate));
+        }
+        auto next = chrono::steady_clock::now();
+        vector<int> need, alloc, free_units, amounts;
+        int pid, total, active;
+
+        while (running_.load(memory_order_relaxed)) {
+            if (interval.count() > 0) {
+                next += interval;
+                auto now = chrono::steady_clock::now();
+                if (now < next) {
+                    this_thread::sleep_until(next);
+                } else if (now - next > interval) {
+                    Bump(c.late);
+                }
+            }
+
+            int pick = static_cast<int>(rng() % total_weight);
+            if ((pick -= profile_.request_weight) < 0) {
+                if (!SampleProcess(rng, pid, need, alloc, free_units)) {
+                    Bump(c.skipped);
+                    continue;
+                }
+                amounts.assign(need.size(), 0);
+                bool any = false;
+                for (size_t j = 0; j < need.size(); j++) {
+                    int cap = min(need[j], free_units[j]);
+                    if (cap > 0) amounts[j] = static_cast<int>(rng() % (cap + 1));
+                    any = any || amounts[j] > 0;
+                }
+                if (!any) {
+                    Bump(c.skipped);
+                    continue;
+                }
+                AdmissionOutcome outcome = TryRequest(pid, amounts);
+                if (outcome == AdmissionOutcome::Granted) {
+                    Bump(c.granted);
+                } else if (outcome == AdmissionOutcome::DeniedUnsafe) {
+                    Bump(c.denied_unsafe);
+                } else {
+                    Bump(c.denied_other);
+                }
+                lock_guard<mutex> history_lock(history_mtx);
+                historical_need.Append(pid, HistoryAction::Need, need);
+            } else if ((pick -= profile_.release_weight) < 0) {
+                if (!SampleProcess(rng, pid, need, alloc, free_units)) {
+                    Bump(c.skipped);
+                    continue;
+                }
+                amounts.assign(alloc.size(), 0);
+                bool any = false;
+                for (size_t j = 0; j < alloc.size(); j++) {
+                    if (alloc[j] > 0) amounts[j] = static_cast<int>(rng() % (alloc[j] + 1));
+                    any = any || amounts[j] > 0;
+                }
+                if (any && TryRelease(pid, amounts)) {
+                    Bump(c.released);
+                } else {
+                    Bump(c.skipped);
+                }
+            } else if ((pick -= profile_.add_weight) < 0) {
+                CountProcesses(total, active);
+                if (total < profile_.max_processes &&
+                    TryAddProcess(1 + static_cast<int>(rng() % 5), 1 + static_cast<int>(rng() % 5),
+                                  PickPartition(rng)) >= 0) {
+                    Bump(c.added);
+                } else {
+                    Bump(c.skipped);
+                }
+            } else {
+                CountProcesses(total, active);
+                if (active > profile_.max_processes / 2 &&
+                    SampleProcess(rng, pid, need, alloc, free_units) && TryRemoveProcess(pid)) {
+                    Bump(c.removed);
+                } else {
+                    Bump(c.skipped);
+                }
+            }
+        }
+    }
+
+    LoadProfile profile_ = {};
+    atomic<bool> running_{false};
+    vector<thread> workers_;
+    unique_ptr<WorkerCounters[]> counters_;
+    chrono::steady_clock::time_point started_;
+    chrono::steady_clock::time_point stopped_;
+};
+
+LoadGenerator load_generator;
+
+void StartSimulation() {
+    if (!load_generator.Start(load_profile)) {
+        cout << "Simulation already running" << endl;
+        return;
+    }
+
+    cout << GREEN << "Simulation started: " << load_profile.threads << " threads, "
+         << (load_profile.open_loop ? "open loop at " + to_string(static_cast<long long>(load_profile.target_rate)) + " ops/s"
+                                    : string("closed loop")) << RESET << endl;
+    LogAction("Simulation", "Started");
+}
+
+void StopSimulation() {
+    if (!load_generator.Running()) {
+        cout << "Simulation is not running" << endl;
+        return;
+    }
+    LoadTotals totals = load_generator.Stop();
+    {
+        unique_lock<shared_mutex> lock(mtx);
+        sim_stats.total_cycles += static_cast<int>(totals.ops);
+    }
+
+    cout << RED << "Simulation stopped" << RESET << endl;
+    cout << "Operations: " << totals.ops << " in " << fixed << setprecision(2) << totals.seconds << " s ("
+         << (totals.seconds > 0 ? totals.ops / totals.seconds : 0.0) << " ops/s)" << endl;
+    cout << "Requests granted: " << totals.granted << ", denied unsafe: " << totals.denied_unsafe
+         << ", denied other: " << totals.denied_other << endl;
+    cout << "Releases: " << totals.released << ", processes added: " << totals.added
+         << ", removed: " << totals.removed << ", skipped: " << totals.skipped << endl;
+    if (load_profile.open_loop) {
+        cout << "Operations started behind schedule: " << totals.late << endl;
+    }
+    LogAction("Simulation", "Stopped after " + to_string(totals.ops) + " operations");
+}
+
+void ConfigureLoadGenerator() {
+    if (load_generator.Running()) {
+        cout << YELLOW << "Stop the simulation before changing its configuration" << RESET << endl;
+        return;
+    }
+    LoadProfile profile = load_profile;
+    int mode;
+    cout << "Enter worker threads: ";
+    cin >> profile.threads;
+    cout << "Enter mode (0=closed loop 1=open loop): ";
+    cin >> mode;
+    profile.open_loop = mode == 1;
+    if (profile.open_loop) {
+        cout << "Enter target rate (ops/s): ";
+        cin >> profile.target_rate;
+    }
+    cout << "Enter workload weights (request release add remove): ";
+    cin >> profile.request_weight >> profile.release_weight >> profile.add_weight >> profile.remove_weight;
+    cout << "Enter maximum process table size: ";
+    cin >> profile.max_processes;
+    if (profile.threads <= 0 || (profile.open_loop && profile.target_rate <= 0) ||
+        profile.request_weight < 0 || profile.release_weight < 0 || profile.add_weight < 0 ||
+        profile.remove_weight < 0 ||
+        profile.request_weight + profile.release_weight + profile.add_weight + profile.remove_weight == 0) {
+        cout << RED << "Invalid load generator configuration" << RESET << endl;
+        return;
+    }
+    load_profile = profile;
+    cout << GREEN << "Load generator configured" << RESET << endl;
+    LogAction("Simulation", "Load generator configured with " + to_string(profile.threads) + " threads");
+}
+
+void ConfigureHistory() {
+    size_t history_capacity, need_capacity;
+    string history_spill, need_spill;
+    {
+        lock_guard<mutex> history_lock(history_mtx);
+        cout << "Allocation history: " << history.size() << "/" << history.capacity() << " entries, "
+             << history.MemoryBytes() / 1024 << " KB, " << history.Spilled() << " spilled"
+             << (history.SpillPath().empty() ? "" : " to " + history.SpillPath()) << endl;
+        cout << "Need samples: " << historical_need.size() << "/" << historical_need.capacity() << " entries, "
+             << historical_need.MemoryBytes() / 1024 << " KB, " << historical_need.Spilled() << " spilled"
+             << (historical_need.SpillPath().empty() ? "" : " to " + historical_need.SpillPath()) << endl;
+    }
+    cout << "Enter allocation history capacity: ";
+    cin >> history_capacity;
+    cout << "Enter need sample capacity: ";
+    cin >> need_capacity;
+    cout << "Enter spill file for evicted history entries (- for none): ";
+    cin >> history_spill;
+    cout << "Enter spill file for evicted need samples (- for none): ";
+    cin >> need_spill;
+    if (history_capacity == 0 || need_capacity == 0 || history_capacity > HistoryRing::kMaxCapacity ||
+        need_capacity > HistoryRing::kMaxCapacity) {
+        cout << RED << "Capacities must be between 1 and " << HistoryRing::kMaxCapacity << RESET << endl;
+        return;
+    }
+
+    lock_guard<mutex> history_lock(history_mtx);
+    history.SetCapacity(history_capacity);
+    historical_need.SetCapacity(need_capacity);
+    bool spill_ok = history.SetSpill(history_spill == "-" ? "" : history_spill);
+    spill_ok = historical_need.SetSpill(need_spill == "-" ? "" : need_spill) && spill_ok;
+    if (!spill_ok) {
+        cout << RED << "Cannot open spill file; evicted entries will be dropped" << RESET << endl;
+    }
+    cout << GREEN << "History configured" << RESET << endl;
+    LogAction("History", "Capacity " + to_string(history_capacity) + " entries, need samples " +
+                         to_string(need_capacity));
+}
+
+void ConfigureAnalytics() {
+    int window;
+    double alpha;
+    cout << "Enter trend window (history records): ";
+    cin >> window;
+    cout << "Enter EWMA smoothing factor (0-1]: ";
+    cin >> alpha;
+    if (window <= 0 || !(alpha > 0 && alpha <= 1)) {
+        cout << RED << "Invalid analytics configuration" << RESET << endl;
+        return;
+    }
+    lock_guard<mutex> history_lock(history_mtx);
+    history_stats.SetWindow(window, history);
+    history_stats.SetAlpha(alpha);
+    cout << GREEN << "Trend window set to " << window << " records" << RESET << endl;
+    LogAction("Analytics", "Window " + to_string(window) + ", alpha " + to_string(alpha));
+}
+
+void ConfigureDeadlockDetection() {
+    int mode;
+    cout << "Current mode: " << (detection_mode == DetectionMode::MultiInstance ? "multi-instance" : "wait-for graph")
+         << endl;
+    cout << "Enter mode (0=multi-instance reduction 1=wait-for graph cycles): ";
+    cin >> mode;
+    if (mode != 0 && mode != 1) {
+        cout << RED << "Invalid detection mode" << RESET << endl;
+        return;
+    }
+    detection_mode = mode == 0 ? DetectionMode::MultiInstance : DetectionMode::WaitForGraph;
+    cout << GREEN << "Deadlock detection mode updated" << RESET << endl;
+    LogAction("Deadlock", string("Detection mode ") + (mode == 0 ? "multi-instance" : "wait-for graph"));
+}
+
+void ConfigureDeadlockRecovery() {
+    int mode;
+    RecoveryWeights w = recovery_weights;
+    cout << "Current mode: " << (recovery_mode == RecoveryMode::Preempt ? "preempt" : "terminate")
+         << ", weights priority " << recovery_weights.priority << " held " << recovery_weights.held << " cpu "
+         << recovery_weights.cpu << " wait " << recovery_weights.wait << endl;
+    cout << "Enter mode (0=preempt and roll back 1=terminate): ";
+    cin >> mode;
+    cout << "Enter weights for priority, held units, cpu usage and wait time: ";
+    cin >> w.priority >> w.held >> w.cpu >> w.wait;
+    if ((mode != 0 && mode != 1) || w.priority < 0 || w.held < 0 || w.cpu < 0 || w.wait < 0) {
+        cout << RED << "Invalid recovery configuration" << RESET << endl;
+        return;
+    }
+    recovery_mode = mode == 0 ? RecoveryMode::Preempt : RecoveryMode::Terminate;
+    recovery_weights = w;
+    cout << GREEN << "Deadlock recovery updated" << RESET << endl;
+    LogAction("Deadlock", string("Recovery mode ") + (mode == 0 ? "preempt" : "terminate"));
+}
+
+void DisplayResourceUtilizationTrends() {
+    cout << "\n" << BOLD << BLUE << "Resource Utilization Trends:" << RESET << endl;
+    shared_lock<shared_mutex> lock(mtx);
+    lock_guard<mutex> history_lock(history_mtx);
+
+    int cycles = history_stats.Window();
+    if (history_stats.WindowFill() < cycles) {
+        cout << "Insufficient history data for trend analysis (need at least " << cycles << " records)" << endl;
+        return;
+    }
+
+    // Only total_resources is read from the state; it changes under mtx exclusive alone
+    for (int j = 0; j < nresources; j++) {
+        double scale = 100.0 / total_resources[j];
+        cout << "R" << j << " average utilization (last " << cycles << " cycles): "
+             << fixed << setprecision(2) << history_stats.WindowMean(j) * scale << "% (std dev "
+             << sqrt(history_stats.WindowVariance(j)) * scale << "%)" << endl;
+    }
+    LogAction("Trends", "Displayed resource utilization trends");
+}
+
+// ======================== Partitioned Admission ========================
+
+// A partition's rows and columns of the state, gathered so the safety check
+// runs on the partition alone. One per thread, reused across requests.
+struct PartitionState {
+    vector<process> processes;
+    ResourceMatrix need_matrix;
+    ResourceMatrix allocation_matrix;
+    vector<int> available;
+    vector<int> request;
+    vector<int> sequence;
+};
+
+thread_local PartitionState partition_state;
+
+// Admission of a member of a partition nothing spans (see
+// ResourcePartitions). The caller holds mtx shared. Returns false without
+// deciding anything when the request has to take the cross-partition path.
+bool TryPartitionedRequest(int pid, const vector<int>& request, AdmissionOutcome& outcome) {
+    if (pid < 0 || pid >= nprocesses || request.size() != static_cast<size_t>(nresources) ||
+        any_of(request.begin(), request.end(), [](int v) { return v < 0; })) {
+        return false;
+    }
+    int k = partitions.PartitionOf(pid);
+    if (k < 0 || partitions.Spanning(k) > 0) return false;
+    unique_lock<shared_mutex> partition_lock(partitions.Lock(k));
+
+    const vector<int>& resources = partitions.Resources(k);
+    const vector<int>& members = partitions.Members(k);
+    const int n = static_cast<int>(members.size()), m = static_cast<int>(resources.size());
+    PartitionState& s = partition_state;
+    s.request.resize(m);
+    for (int c = 0; c < m; c++) s.request[c] = request[resources[c]];
+
+    // A member's Need is zero outside the partition, so units asked for there exceed it
+    bool within_need = true;
+    for (int j = 0; j < nresources; j++) {
+        if (request[j] > 0 && partitions.PartitionOfResource(j) != k) within_need = false;
+    }
+    for (int c = 0; c < m && within_need; c++) within_need = s.request[c] <= need_matrix(pid, resources[c]);
+    bool can_request = within_need;
+    for (int c = 0; c < m && can_request; c++) can_request = s.request[c] <= available[resources[c]];
+
+    bool safe = false;
+    if (can_request) {
+        s.processes.resize(n);
+        s.need_matrix.Reset(n, m);
+        s.allocation_matrix.Reset(n, m);
+        s.available.resize(m);
+        for (int i = 0; i < n; i++) {
+            s.processes[i].status = false;
+            const int* need = need_matrix.Row(members[i]);
+            const int* alloc = allocation_matrix.Row(members[i]);
+            int* part_need = s.need_matrix.Row(i);
+            int* part_alloc = s.allocation_matrix.Row(i);
+            for (int c = 0; c < m; c++) {
+                part_need[c] = need[resources[c]];
+                part_alloc[c] = alloc[resources[c]];
+            }
+        }
+        for (int c = 0; c < m; c++) s.available[c] = available[resources[c]];
+        safe = safety_engine.Run(s.processes, s.need_matrix, s.allocation_matrix, s.available, s.sequence,
+                                 partitions.Slot(pid), s.request.data());
+    }
+    outcome = !can_request ? AdmissionOutcome::DeniedInsufficient
+              : safe       ? AdmissionOutcome::Granted
+                           : AdmissionOutcome::DeniedUnsafe;
+
+    {
+        lock_guard<mutex> row_lock(release_stripes[pid % kReleaseStripes]);
+        BeginRelease();
+        if (outcome == AdmissionOutcome::Granted) {
+            for (int c = 0; c < m; c++) {
+                int j = resources[c];
+                AtomicAdd(available[j], -s.request[c]);
+                allocation_matrix(pid, j) += s.request[c];
+                need_matrix(pid, j) -= s.request[c];
+            }
+            fill(request_matrix.Row(pid), request_matrix.Row(pid) + nresources, 0);
+            MarkRowWritten(pid);
+        } else {
+            processes[pid].wait_time += 1;
+            if (within_need) copy(request.begin(), request.end(), request_matrix.Row(pid));
+            state_views.MarkDirty(pid);  // wait_time and the outstanding request
+        }
+        EndRelease();
+    }
+    if (outcome == AdmissionOutcome::Granted) {
+        AddBlock("P" + to_string(pid) + " allocated resources");
+        RecordHistory(pid, request, HistoryAction::Allocate);
+    }
+
+    RecordOp(TraceOp::Request, pid, request.data(), request.size(), static_cast<int>(outcome));
+    sim_stats.requests_processed++;
+    LogAction("Request", "P" + to_string(pid) + " requested resources");
+    return true;
+}
+
+// Declare the resource partitions (an empty list turns them off) and assign
+// the processes to them
+bool TryConfigurePartitions(const vector<vector<int>>& groups, string& error) {
+    unique_lock<shared_mutex> lock(mtx);
+    if (!partitions.Configure(groups, nresources, error)) return false;
+    partitions.Rebuild(processes, max_matrix, allocation_matrix, need_matrix);
+    LogAction("Partitions", to_string(groups.size()) + " resource partitions declared");
+    return true;
+}
+
+void ConfigurePartitions() {
+    {
+        shared_lock<shared_mutex> lock(mtx);
+        if (partitions.Count() == 0) {
+            cout << "Resources are not partitioned: every request takes the global path" << endl;
+        }
+        int members = 0;
+        for (int k = 0; k < partitions.Count(); k++) {
+            cout << "Partition " << k + 1 << ":";
+            for (int j : partitions.Resources(k)) cout << " R" << j;
+            cout << "  members " << partitions.Members(k).size();
+            if (partitions.Spanning(k) > 0) {
+                cout << YELLOW << "  spanned by " << partitions.Spanning(k) << " processes" << RESET;
+            }
+            cout << endl;
+            members += static_cast<int>(partitions.Members(k).size());
+        }
+        if (partitions.Count() > 0) {
+            int active = static_cast<int>(count_if(processes.begin(), processes.end(),
+                                                   [](const process& p) { return !p.status; }));
+            cout << "Active processes outside every partition: " << active - members << endl;
+        }
+    }
+
+    int count;
+    cout << "Enter number of partitions (0 to turn partitioning off): ";
+    cin >> count;
+    if (count < 0) {
+        cout << RED << "Number of partitions cannot be negative" << RESET << endl;
+        return;
+    }
+    vector<vector<int>> groups(count);
+    for (int k = 0; k < count; k++) {
+        int size;
+        cout << "Partition " << k + 1 << " (number of resource types, then the types): ";
+        cin >> size;
+        groups[k].resize(max(0, size));
+        for (int& j : groups[k]) cin >> j;
+    }
+
+    string error;
+    if (!TryConfigurePartitions(groups, error)) {
+        cout << RED << "Partitions not changed: " << error << RESET << endl;
+        return;
+    }
+    if (count == 0) {
+        cout << GREEN << "Resource partitioning turned off" << RESET << endl;
+    } else {
+        cout << GREEN << "Declared " << count << " resource partitions" << RESET << endl;
+    }
+}
+
+// ======================== New Features ========================
+
+// The Try* functions are the quiet cores of the mutating operations: they
+// print nothing and report the outcome to the caller. The menu wrappers
+// below and the load generator both go through them.
+
+// The max applies to the listed resource types, or to all of them if none
+// are listed, so a process can be confined to a resource partition. Returns
+// -1 if a listed type does not exist. The cpu_usage is drawn at random
+// unless replay passes the recorded one back in, in hundredths.
+int TryAddProcess(int max_resources, int priority, const vector<int>& resources, int cpu_percent) {
+    WalCommit commit;
+    unique_lock<shared_mutex> lock(mtx);
+    if (cpu_percent < 0) cpu_percent = rand() % 50 + 10; // Random CPU usage 0.1-0.6
+    vector<int> args = {max_resources, priority, cpu_percent};
+    args.insert(args.end(), resources.begin(), resources.end());
+    if (any_of(resources.begin(), resources.end(), [](int j) { return j < 0 || j >= nresources; })) {
+        RecordOp(TraceOp::AddProcess, -1, args.data(), args.size(), 0);
+        return -1;
+    }
+    process p;
+    p.id = nprocesses;
+    p.status = false;
+    p.priority = priority;
+    p.start_time = time(nullptr);
+    p.end_time = 0;
+    p.cpu_usage = cpu_percent / 100.0;
+    p.wait_time = 0;
+    processes.push_back(p);
+    max_matrix.AppendRow(resources.empty() ? max_resources : 0);
+    for (int j : resources) max_matrix(p.id, j) = max_resources;
+    allocation_matrix.AppendRow(0);
+    need_matrix.AppendRow(max_matrix.RowVector(p.id));
+    request_matrix.AppendRow(0);
+    wait_for_graph.AddProcess();
+    state_views.AddProcess();
+    partitions.AddProcess(p.id, true, max_matrix.Row(p.id), allocation_matrix.Row(p.id), need_matrix.Row(p.id));
+    nprocesses++;
+    RecordOp(TraceOp::AddProcess, p.id, args.data(), args.size(), 1);
+    string transaction = "Added process P" + to_string(p.id);
+    AddBlock(transaction);
+    LogAction("AddProcess", "P" + to_string(p.id) + " added");
+    return p.id;
+}
+
+void AddProcess(int max_resources, int priority, const vector<int>& resources) {
+    int pid = TryAddProcess(max_resources, priority, resources);
+    if (pid < 0) {
+        cout << RED << "Cannot add process: no such resource type" << RESET << endl;
+        return;
+    }
+    cout << GREEN << "Added process P" << pid << " with max resources " << max_resources 
+         << " and priority " << priority << RESET << endl;
+}
+
+// Returns the process's allocation to available and clears its row, so a
+// later release against the finished process cannot return units twice.
+bool TryRemoveProcess(int pid) {
+    WalCommit commit;
+    unique_lock<shared_mutex> lock(mtx);
+    if (pid < 0 || pid >= nprocesses || processes[pid].status) {
+        RecordOp(TraceOp::RemoveProcess, pid, nullptr, 0, 0);
+        return false;
+    }
+
+    partitions.RemoveProcess(pid);
+    for (int j = 0; j < nresources; j++) {
+        available[j] += allocation_matrix(pid, j);
+        allocation_matrix(pid, j) = 0;
+        need_matrix(pid, j) = 0;
+        request_matrix(pid, j) = 0;
+    }
+    processes[pid].status = true;
+    processes[pid].end_time = time(nullptr);
+    MarkRowWritten(pid);
+    RecordOp(TraceOp::RemoveProcess, pid, nullptr, 0, 1);
+    string transaction = "Removed process P" + to_string(pid);
+    AddBlock(transaction);
+    LogAction("RemoveProcess", "P" + to_string(pid) + " removed");
+    return true;
+}
+
+void RemoveProcess(int pid) {
+    if (!TryRemoveProcess(pid)) {
+        cout << RED << "Invalid or already completed process P" << pid << RESET << endl;
+        return;
+    }
+    cout << GREEN << "Removed process P" << pid << RESET << endl;
+}
+
+// Latency is measured from entry, so time spent waiting for mtx counts
+AdmissionOutcome TryRequest(int pid, const vector<int>& request) {
+    ScopedLatency timer(LatencyOp::Request);
+    WalCommit commit;
+    if (partitions.Enabled()) {
+        shared_lock<shared_mutex> lock(mtx);
+        AdmissionOutcome outcome;
+        if (TryPartitionedRequest(pid, request, outcome)) return outcome;
+    }
+    unique_lock<shared_mutex> lock(mtx);
+    if (pid < 0 || pid >= nprocesses || request.size() != static_cast<size_t>(nresources) ||
+        any_of(request.begin(), request.end(), [](int v) { return v < 0; })) {
+        RecordOp(TraceOp::Request, pid, request.data(), request.size(), static_cast<int>(AdmissionOutcome::Invalid));
+        return AdmissionOutcome::Invalid;
+    }
+
+    AdmissionOutcome outcome;
+    bool within_need = row_kernels.fits(request.data(), need_matrix.Row(pid), nresources);
+    bool can_request = within_need && row_kernels.fits(request.data(), available.data(), nresources);
+
+    if (can_request) {
+        TentativeAllocation tentative(pid, request);
+        if (tentative.Evaluate()) {
+            tentative.Commit();
+            string transaction = "P" + to_string(pid) + " allocated resources";
+            AddBlock(transaction);
+            RecordHistory(pid, request, HistoryAction::Allocate);
+            outcome = AdmissionOutcome::Granted;
+        } else {
+            processes[pid].wait_time += 1;
+            outcome = AdmissionOutcome::DeniedUnsafe;
+        }
+    } else {
+        processes[pid].wait_time += 1;
+        outcome = AdmissionOutcome::DeniedInsufficient;
+    }
+    // A request beyond the process's Need is one it can never be granted, so
+    // it is not recorded as outstanding: the detector would count the process
+    // as blocked on it and recovery would preempt it for nothing.
+    if (outcome == AdmissionOutcome::Granted) {
+        fill(request_matrix.Row(pid), request_matrix.Row(pid) + nresources, 0);
+    } else if (within_need) {
+        copy(request.begin(), request.end(), request_matrix.Row(pid));
+    }
+    state_views.MarkDirty(pid);  // wait_time and the outstanding request
+
+    RecordOp(TraceOp::Request, pid, request.data(), request.size(), static_cast<int>(outcome));
+    sim_stats.requests_processed++;
+    LogAction("Request", "P" + to_string(pid) + " requested resources");
+    return outcome;
+}
+
+void RequestResources(int pid, const vector<int>& request) {
+    {
+        shared_lock<shared_mutex> lock(mtx);
+        ValidateInput(pid, request, "request");
+    }
+    switch (TryRequest(pid, request)) {
+        case AdmissionOutcome::Granted:
+            cout << GREEN << "Request granted for P" << pid << RESET << endl;
+            break;
+        case AdmissionOutcome::DeniedUnsafe:
+            cout << RED << "Request denied: Unsafe state" << RESET << endl;
+            break;
+        case AdmissionOutcome::DeniedInsufficient:
+            cout << YELLOW << "Request denied: Insufficient resources or exceeds need" << RESET << endl;
+            break;
+        case AdmissionOutcome::Invalid:
+            cout << RED << "Request rejected: process table changed" << RESET << endl;
+            break;
+    }
+}
+
+// Admit a burst of requests in one critical section. Requests are considered
+// in priority order (lower number first, ties in arrival order) and each one
+// is granted if the state stays safe on top of every earlier grant. The need
+// orderings of the safety engine are built once for the whole batch; after a
+// grant only the requesting row is re-sorted. Outcomes are returned in input
+// order.
+vector<AdmissionOutcome> RequestResourcesBatch(const vector<PendingRequest>& batch) {
+    WalCommit commit;
+    unique_lock<shared_mutex> lock(mtx);
+    vector<AdmissionOutcome> outcomes(batch.size(), AdmissionOutcome::Invalid);
+
+    vector<size_t> order;
+    for (size_t k = 0; k < batch.size(); k++) {
+        const PendingRequest& r = batch[k];
+        bool valid = r.pid >= 0 && r.pid < nprocesses &&
+                     r.request.size() == static_cast<size_t>(nresources) &&
+                     all_of(r.request.begin(), r.request.end(), [](int v) { return v >= 0; });
+        if (valid) {
+            order.push_back(k);
+        } else {
+            RecordOp(TraceOp::Request, r.pid, r.request.data(), r.request.size(),
+                     static_cast<int>(AdmissionOutcome::Invalid));
+        }
+    }
+    stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return processes[batch[a].pid].priority < processes[batch[b].pid].priority;
+    });
+
+    safety_engine.Prepare(processes, need_matrix);
+    int granted = 0;
+    for (size_t k : order) {
+        ScopedLatency timer(LatencyOp::Request);
+        int pid = batch[k].pid;
+        const vector<int>& request = batch[k].request;
+
+        bool within_need = row_kernels.fits(request.data(), need_matrix.Row(pid), nresources);
+        bool can_request = within_need && row_kernels.fits(request.data(), available.data(), nresources);
+        if (!can_request) {
+            outcomes[k] = AdmissionOutcome::DeniedInsufficient;
+            processes[pid].wait_time += 1;
+        } else {
+            TentativeAllocation tentative(pid, request);
+            if (tentative.EvaluatePrepared()) {
+                tentative.Commit();
+                safety_engine.UpdateRow(pid, need_matrix);
+                AddBlock("P" + to_string(pid) + " allocated resources");
+                RecordHistory(pid, request, HistoryAction::Allocate);
+                outcomes[k] = AdmissionOutcome::Granted;
+                granted++;
+            } else {
+                outcomes[k] = AdmissionOutcome::DeniedUnsafe;
+                processes[pid].wait_time += 1;
+            }
+        }
+        if (outcomes[k] == AdmissionOutcome::Granted) {
+            fill(request_matrix.Row(pid), request_matrix.Row(pid) + nresources, 0);
+        } else if (within_need) {
+            copy(request.begin(), request.end(), request_matrix.Row(pid));
+        }
+        state_views.MarkDirty(pid);
+
+        RecordOp(TraceOp::Request, pid, request.data(), request.size(), static_cast<int>(outcomes[k]));
+        sim_stats.requests_processed++;
+    }
+
+    LogAction("BatchRequest", to_string(granted) + " of " + to_string(batch.size()) + " requests granted");
+    return outcomes;
+}
+
+void BatchRequestMenu() {
+    int count;
+    cout << "Enter number of requests: ";
+    cin >> count;
+    if (count <= 0) {
+        cout << RED << "Batch must contain at least one request" << RESET << endl;
+        return;
+    }
+
+    vector<PendingRequest> batch(count);
+    for (int k = 0; k < count; k++) {
+        cout << "Request " << k + 1 << " (PID R0 R1 ...): ";
+        cin >> batch[k].pid;
+        batch[k].request.resize(nresources);
+        for (int j = 0; j < nresources; j++) cin >> batch[k].request[j];
+    }
+
+    vector<AdmissionOutcome> outcomes = RequestResourcesBatch(batch);
+    cout << "\n" << BOLD << "Batch Admission Results:" << RESET << endl;
+    for (int k = 0; k < count; k++) {
+        cout << "#" << k + 1 << " P" << batch[k].pid << ": ";
+        switch (outcomes[k]) {
+            case AdmissionOutcome::Granted:
+                cout << GREEN << "Granted" << RESET << endl;
+                break;
+            case AdmissionOutcome::DeniedUnsafe:
+                cout << RED << "Denied: Unsafe state" << RESET << endl;
+                break;
+            case AdmissionOutcome::DeniedInsufficient:
+                cout << YELLOW << "Denied: Insufficient resources or exceeds need" << RESET << endl;
+                break;
+            case AdmissionOutcome::Invalid:
+                cout << RED << "Invalid request" << RESET << endl;
+                break;
+        }
+    }
+}
+
+bool TryRelease(int pid, const vector<int>& release) {
+    ScopedLatency timer(LatencyOp::Release);
+    WalCommit commit;
+    shared_lock<shared_mutex> lock(mtx);
+    if (pid < 0 || pid >= nprocesses || release.size() != static_cast<size_t>(nresources) ||
+        any_of(release.begin(), release.end(), [](int v) { return v < 0; })) {
+        RecordOp(TraceOp::Release, pid, release.data(), release.size(), 0);
+        return false;
+    }
+    // Members of a partition hold its lock shared, so its admissions see no release half done
+    shared_lock<shared_mutex> partition_lock;
+    int partition = partitions.PartitionOf(pid);
+    if (partition >= 0) partition_lock = shared_lock<shared_mutex>(partitions.Lock(partition));
+    lock_guard<mutex> row_lock(release_stripes[pid % kReleaseStripes]);
+
+    bool can_release = true;
+    for (int j = 0; j < nresources; j++) {
+        if (release[j] > allocation_matrix(pid, j)) {
+            can_release = false;
+            break;
+        }
+    }
+
+    if (can_release) {
+        BeginRelease();
+        for (int j = 0; j < nresources; j++) {
+            allocation_matrix(pid, j) -= release[j];
+            need_matrix(pid, j) += release[j];
+            AtomicAdd(available[j], release[j]);
+        }
+        MarkRowWritten(pid);
+        EndRelease();
+        string transaction = "P" + to_string(pid) + " released resources";
+        AddBlock(transaction);
+        RecordHistory(pid, release, HistoryAction::Release);
+    }
+    RecordOp(TraceOp::Release, pid, release.data(), release.size(), can_release);
+    LogAction("Release", "P" + to_string(pid) + " released resources");
+    return can_release;
+}
+
+void ReleaseResources(int pid, const vector<int>& release) {
+    {
+        shared_lock<shared_mutex> lock(mtx);
+        ValidateInput(pid, release, "release");
+    }
+    if (TryRelease(pid, release)) {
+        cout << GREEN << "Resources released for P" << pid << RESET << endl;
+    } else {
+        cout << RED << "Cannot release: Exceeds allocated resources" << RESET << endl;
+    }
+}
+
+// Every set of deadlocked processes (see WaitForGraph)
+vector<vector<int>> FindDeadlockedSets(vector<int>* cycle) {
+    shared_lock<shared_mutex> lock(mtx);
+    return wait_for_graph.FindDeadlockedSets(processes, need_matrix, allocation_matrix, available, cycle);
+}
+
+// Deadlocked processes by the multi-instance reduction (see
+// DeadlockDetector). The caller must hold mtx.
+vector<int> DeadlockedProcessesLocked() {
+    vector<int> deadlocked;
+    int threads = max(1u, thread::hardware_concurrency());
+    ReadConsistent([&] {
+        deadlocked = deadlock_detector.Detect(processes, request_matrix, allocation_matrix, available, threads);
+    });
+    return deadlocked;
+}
+
+vector<int> FindDeadlockedProcesses() {
+    shared_lock<shared_mutex> lock(mtx);
+    return DeadlockedProcessesLocked();
+}
+
+// Returns the processes of a wait cycle (first one repeated at the end), or
+// an empty vector if there is none
+vector<int> FindDeadlockCycle() {
+    vector<int> cycle;
+    FindDeadlockedSets(&cycle);
+    return cycle;
+}
+
+void DetectDeadlockCycle() {
+    cout << "\n" << BOLD << RED << "Deadlock Cycle Detection:" << RESET << endl;
+    if (detection_mode == DetectionMode::MultiInstance) {
+        vector<int> deadlocked = FindDeadlockedProcesses();
+        if (!deadlocked.empty()) {
+            cout << RED << "Deadlocked processes: ";
+            for (size_t i = 0; i < deadlocked.size(); i++) cout << (i ? ", " : "") << "P" << deadlocked[i];
+            cout << RESET << endl;
+            sim_stats.deadlocks_detected++;
+        } else {
+            cout << GREEN << "No deadlock detected" << RESET << endl;
+        }
+        LogAction("DeadlockCycle", to_string(deadlocked.size()) + " deadlocked processes");
+        return;
+    }
+
+    vector<int> cycle;
+    vector<vector<int>> sets = FindDeadlockedSets(&cycle);
+    bool cycle_found = !cycle.empty();
+    if (cycle_found) {
+        cout << RED << "Deadlock cycle detected: ";
+        for (size_t i = 0; i < cycle.size(); i++) {
+            cout << "P" << cycle[i];
+            if (i < cycle.size() - 1) cout << " -> ";
+        }
+        cout << RESET << endl;
+        cout << RED << sets.size() << " deadlocked set" << (sets.size() == 1 ? "" : "s") << ":" << RESET << endl;
+        for (const auto& set : sets) {
+            cout << "  {";
+            for (size_t i = 0; i < set.size(); i++) cout << (i ? ", " : "") << "P" << set[i];
+            cout << "}" << endl;
+        }
+        sim_stats.deadlocks_detected++;
+    } else {
+        cout << GREEN << "No deadlock cycle detected" << RESET << endl;
+    }
+    LogAction("DeadlockCycle", cycle_found ? "Cycle detected" : "No cycle detected");
+}
+
+// Write the state in the system_state.txt format. The caller must hold mtx.
+void WriteStateText(ostream& out, bool include_history) {
+    out << "nprocesses: " << nprocesses << "\n";
+    out << "nresources: " << nresources << "\n";
+    out << "available: ";
+    for (int a : available) out << a << " ";
+    out << "\n";
+    out << "total_resources: ";
+    for (int t : total_resources) out << t << " ";
+    out << "\n";
+
+    out << "processes:\n";
+    for (const auto& p : processes) {
+        out << "id: " << p.id << "\n";
+        out << "Max: ";
+        for (int j = 0; j < nresources; j++) out << max_matrix(p.id, j) << " ";
+        out << "\nAllocation: ";
+        for (int j = 0; j < nresources; j++) out << allocation_matrix(p.id, j) << " ";
+        out << "\nNeed: ";
+        for (int j = 0; j < nresources; j++) out << need_matrix(p.id, j) << " ";
+        out << "\nstatus: " << (p.status ? "true" : "false") << "\n";
+        out << "priority: " << p.priority << "\n";
+        out << "cpu_usage: " << fixed << setprecision(2) << p.cpu_usage << "\n";
+        out << "wait_time: " << p.wait_time << "\n";
+    }
+
+    out << "history:\n";
+    if (!include_history) return;
+    lock_guard<mutex> history_lock(history_mtx);
+    for (size_t i = 0; i < history.size(); i++) {
+        AllocationHistory h = history[i];
+        out << "pid: " << h.pid << "\n";
+        out << "resources: ";
+        for (int j = 0; j < history.width(); j++) out << h.resources[j] << " ";
+        out << "\ntimestamp: " << h.timestamp << "\n";
+        out << "action: " << HistoryActionName(h.action) << "\n";
+    }
+}
+
+bool TryExportToText(const string& filename) {
+    unique_lock<shared_mutex> lock(mtx);
+    ofstream file(filename);
+    if (!file.is_open()) return false;
+    WriteStateText(file, true);
+    file.close();
+    LogAction("Export", "System state exported to text");
+    return true;
+}
+
+void ExportToText(const string& filename) {
+    if (!TryExportToText(filename)) {
+        cout << RED << "Failed to open file for export: " << filename << RESET << endl;
+        return;
+    }
+    cout << GREEN << "System state exported to " << filename << RESET << endl;
+}
+
+void DisplayProcessStatus() {
+    cout << "\n" << BOLD << CYAN << "Process Status Monitor:" << RESET << endl;
+    shared_ptr<const StateView> view = state_views.Acquire(banker);
+    cout << "PID\tStatus\tCPU Usage\tWait Time\tPriority\n";
+    for (const auto& p : view->processes) {
+        cout << "P" << p.id << "\t" << (p.status ? "Done" : "Active") << "\t"
+             << fixed << setprecision(2) << p.cpu_usage * 100 << "%\t"
+             << p.wait_time << "s\t" << p.priority << endl;
+    }
+    LogAction("Status", "Displayed process status");
+}
+
+// Read-only view of a whole file: mapped where the platform allows,
+// otherwise read into memory
+class MappedFile {
+public:
+    MappedFile() : data_(nullptr), size_(0) {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { Close(); }
+
+    bool Open(const string& path) {
+        Close();
+#ifdef _WIN32
+        ifstream in(path, ios::binary);
+        if (!in.is_open()) return false;
+        copy_.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        data_ = copy_.data();
+        size_ = copy_.size();
+        return true;
+#else
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED) {
+                close(fd);
+                size_ = 0;
+                return false;
+            }
+            madvise(map, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(map);
+        }
+        close(fd);
+        return true;
+#endif
+    }
+
+    void Close() {
+#ifdef _WIN32
+        copy_.clear();
+#else
+        if (data_) munmap(const_cast<char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+#ifdef _WIN32
+    vector<char> copy_;
+#endif
+};
+
+// Single pass over text in the system_state.txt format. Every line is
+// "key: value". The header keys, the fields of a process and those of a
+// history entry may come in any order; a process or history record ends
+// where one of its keys repeats or its section ends, and processes are
+// placed by id. Numbers are scanned in place and rows go straight into flat
+// arrays. Errors throw invalid_argument as "line:column: message", and
+// nothing outside the parser changes until ApplyStateText().
+class StateTextParser {
+public:
+    int nprocesses, nresources;
+    vector<int> available, total_resources;
+    vector<process> processes;
+    vector<int> max_rows, allocation_rows, need_rows;  // nprocesses x nresources
+    vector<int> history_pids;
+    vector<HistoryAction> history_actions;
+    vector<time_t> history_times;
+    vector<int> history_rows;                          // entries x nresources
+
+    void Parse(const char* data, size_t size) {
+        pos_ = data;
+        end_ = data + size;
+        size_ = size;
+        line_ = 0;
+        nprocesses = nresources = -1;
+        available.clear();
+        total_resources.clear();
+        processes.clear();
+        history_pids.clear();
+        history_actions.clear();
+        history_times.clear();
+        history_rows.clear();
+        Section section = Section::Header;
+        int header_seen = 0, available_line = 0, total_line = 0, count_line = 0;
+        record_seen_ = 0;
+
+        while (NextLine()) {
+            if (key_.empty()) continue;
+            if (section == Section::Header) {
+                if (key_ == "processes" && value_ == eol_) {
+                    EndHeader(header_seen, available_line, total_line, count_line);
+                    section = Section::Processes;
+                } else if (key_ == "nprocesses" || key_ == "nresources") {
+                    int value = ParseInt(value_);
+                    ExpectEnd();
+                    if (value < 0) Fail(value_, "expected a count");
+                    // Every process and resource takes at least a byte of the file
+                    if (static_cast<size_t>(value) > size_) Fail(value_, "count exceeds the size of the file");
+                    (key_ == "nprocesses" ? nprocesses : nresources) = value;
+                    count_line = max(count_line, line_);
+                    header_seen |= key_ == "nprocesses" ? 1 : 2;
+                } else if (key_ == "available" || key_ == "total_resources") {
+                    ParseRow(key_ == "available" ? available : total_resources);
+                    (key_ == "available" ? available_line : total_line) = line_;
+                    header_seen |= key_ == "available" ? 4 : 8;
+                } else {
+                    Fail(key_.data(), "unknown header field '" + string(key_) + "'");
+                }
+            } else if (section == Section::Processes) {
+                if (key_ == "history" && value_ == eol_) {
+                    EndProcess();
+                    if (static_cast<int>(processes.size()) != nprocesses) {
+                        Fail(key_.data(), "expected " + to_string(nprocesses) + " processes, found " +
+                                              to_string(processes.size()));
+                    }
+                    section = Section::History;
+                } else {
+                    ProcessField();
+                }
+            } else {
+                HistoryField();
+            }
+        }
+
+        if (section == Section::Header) {
+            EndHeader(header_seen, available_line, total_line, count_line);
+            Fail(nullptr, "missing 'processes:' section");
+        }
+        if (section == Section::Processes) {
+            EndProcess();
+            if (static_cast<int>(processes.size()) != nprocesses) {
+                Fail(nullptr, "expected " + to_string(nprocesses) + " processes, found " + to_string(processes.size()));
+            }
+        } else {
+            EndHistory();
+        }
+    }
+
+private:
+    enum class Section { Header, Processes, History };
+    enum ProcessKey { kId = 1, kMax = 2, kAllocation = 4, kNeed = 8, kStatus = 16, kPriority = 32,
+                      kCpuUsage = 64, kWaitTime = 128, kAllProcessKeys = 255 };
+    enum HistoryKey { kPid = 1, kResources = 2, kTimestamp = 4, kAction = 8, kAllHistoryKeys = 15 };
+
+    [[noreturn]] void Fail(const char* at, const string& message) const {
+        string where = to_string(line_);
+        if (at) where += ":" + to_string(at - line_start_ + 1);
+        throw invalid_argument(where + ": " + message);
+    }
+
+    // Split the next line into key_ and the value range [value_, eol_),
+    // trailing blanks and '\r' removed. key_ is empty on a blank line.
+    bool NextLine() {
+        if (pos_ >= end_) return false;
+        line_++;
+        line_start_ = pos_;
+        const char* newline = static_cast<const char*>(memchr(pos_, '\n', end_ - pos_));
+        eol_ = newline ? newline : end_;
+        pos_ = newline ? newline + 1 : end_;
+        while (eol_ > line_start_ && (eol_[-1] == '\r' || eol_[-1] == ' ' || eol_[-1] == '\t')) eol_--;
+        const char* p = line_start_;
+        while (p < eol_ && (*p == ' ' || *p == '\t')) p++;
+        if (p == eol_) {
+            key_ = string_view();
+            return true;
+        }
+        const char* colon = static_cast<const char*>(memchr(p, ':', eol_ - p));
+        if (!colon) Fail(p, "expected 'key: value'");
+        key_ = string_view(p, colon - p);
+        value_ = colon + 1;
+        while (value_ < eol_ && (*value_ == ' ' || *value_ == '\t')) value_++;
+        return true;
+    }
+
+    void ExpectEnd() {
+        if (cursor_ != eol_) Fail(cursor_, "unexpected text after the value");
+    }
+
+    // Integer at p, leaving cursor_ after it
+    long long ParseInt64(const char* p) {
+        const char* start = p;
+        bool negative = p < eol_ && *p == '-';
+        if (p < eol_ && (*p == '-' || *p == '+')) p++;
+        if (p == eol_ || *p < '0' || *p > '9') Fail(start, "expected an integer");
+        const unsigned long long kLimit = LLONG_MAX;
+        unsigned long long value = 0;
+        for (; p < eol_ && *p >= '0' && *p <= '9'; p++) {
+            unsigned digit = *p - '0';
+            if (value >= kLimit / 10 && (value > kLimit / 10 || digit > kLimit % 10)) Fail(start, "integer out of range");
+            value = value * 10 + digit;
+        }
+        if (p < eol_ && *p != ' ' && *p != '\t') Fail(start, "expected an integer");
+        cursor_ = p;
+        return negative ? -static_cast<long long>(value) : static_cast<long long>(value);
+    }
+
+    int ParseInt(const char* p) {
+        long long value = ParseInt64(p);
+        if (value < INT_MIN || value > INT_MAX) Fail(p, "integer out of range");
+        return static_cast<int>(value);
+    }
+
+    // Whitespace-separated integers up to the end of the line. Unsigned
+    // values of up to 9 digits cannot overflow and skip the checked path.
+    void ParseRow(vector<int>& row) {
+        row.clear();
+        const char* p = value_;
+        while (true) {
+            while (p < eol_ && (*p == ' ' || *p == '\t')) p++;
+            if (p == eol_) break;
+            const char* q = p;
+            unsigned value = 0;
+            while (q < eol_ && q - p < 9 && static_cast<unsigned>(*q - '0') < 10) value = value * 10 + (*q++ - '0');
+            if (q > p && (q == eol_ || *q == ' ' || *q == '\t')) {
+                row.push_back(static_cast<int>(value));
+                p = q;
+            } else {
+                row.push_back(ParseInt(p));
+                p = cursor_;
+            }
+        }
+    }
+
+    void ParseRowOf(vector<int>& row, const char* what) {
+        ParseRow(row);
+        if (static_cast<int>(row.size()) != nresources) {
+            Fail(value_, string(what) + " has " + to_string(row.size()) + " values, expected " +
+                             to_string(nresources));
+        }
+    }
+
+    void EndHeader(int seen, int available_line, int total_line, int count_line) {
+        const char* names[] = {"nprocesses", "nresources", "available", "total_resources"};
+        for (int k = 0; k < 4; k++) {
+            if (!(seen & (1 << k))) Fail(nullptr, string("missing header field '") + names[k] + "'");
+        }
+        if (static_cast<int>(available.size()) != nresources) {
+            line_ = available_line;
+            Fail(nullptr, "available has " + to_string(available.size()) + " values, expected " + to_string(nresources));
+        }
+        if (static_cast<int>(total_resources.size()) != nresources) {
+            line_ = total_line;
+            Fail(nullptr, "total_resources has " + to_string(total_resources.size()) + " values, expected " +
+                              to_string(nresources));
+        }
+        // Each cell has a value in the Max, Allocation and Need rows, so a
+        // header asking for more than the file can hold is rejected before
+        // anything is allocated for it
+        size_t cells = static_cast<size_t>(nprocesses) * nresources;
+        if (cells > size_ / 3) {
+            line_ = count_line;
+            Fail(nullptr, to_string(nprocesses) + " processes x " + to_string(nresources) +
+                              " resources do not fit in a file of " + to_string(size_) + " bytes");
+        }
+        max_rows.assign(cells, 0);
+        allocation_rows.assign(cells, 0);
+        need_rows.assign(cells, 0);
+        processes.reserve(nprocesses);
+        placed_.assign(nprocesses, 0);
+    }
+
+    void ProcessField() {
+        int key;
+        if (key_ == "id") key = kId;
+        else if (key_ == "Max") key = kMax;
+        else if (key_ == "Allocation") key = kAllocation;
+        else if (key_ == "Need") key = kNeed;
+        else if (key_ == "status") key = kStatus;
+        else if (key_ == "priority") key = kPriority;
+        else if (key_ == "cpu_usage") key = kCpuUsage;
+        else if (key_ == "wait_time") key = kWaitTime;
+        else Fail(key_.data(), "unknown process field '" + string(key_) + "'");
+        if (record_seen_ & key) EndProcess();
+        if (record_seen_ == 0) {
+            record_line_ = line_;
+            record_ = process();
+        }
+        record_seen_ |= key;
+
+        switch (key) {
+            case kId:
+                record_.id = ParseInt(value_);
+                ExpectEnd();
+                if (record_.id < 0 || record_.id >= nprocesses) Fail(value_, "process id out of range");
+                if (placed_[record_.id]) Fail(value_, "duplicate process id " + to_string(record_.id));
+                break;
+            case kMax:
+                ParseRowOf(max_row_, "Max");
+                break;
+            case kAllocation:
+                ParseRowOf(allocation_row_, "Allocation");
+                break;
+            case kNeed:
+                ParseRowOf(need_row_, "Need");
+                break;
+            case kStatus:
+                if (string_view(value_, eol_ - value_) == "true") {
+                    record_.status = true;
+                } else if (string_view(value_, eol_ - value_) == "false") {
+                    record_.status = false;
+                } else {
+                    Fail(value_, "expected true or false");
+                }
+                break;
+            case kPriority:
+                record_.priority = ParseInt(value_);
+                ExpectEnd();
+                break;
+            case kCpuUsage:
+                record_.cpu_usage = ParseDouble(value_);
+                break;
+            case kWaitTime:
+                record_.wait_time = ParseInt(value_);
+                ExpectEnd();
+                break;
+        }
+    }
+
+    void EndProcess() {
+        if (record_seen_ == 0) return;
+        if (record_seen_ != kAllProcessKeys) {
+            const char* names[] = {"id", "Max", "Allocation", "Need", "status", "priority", "cpu_usage", "wait_time"};
+            for (int k = 0; k < 8; k++) {
+                if (!(record_seen_ & (1 << k))) {
+                    line_ = record_line_;
+                    Fail(nullptr, string("process is missing '") + names[k] + "'");
+                }
+            }
+        }
+        size_t offset = static_cast<size_t>(record_.id) * nresources;
+        copy(max_row_.begin(), max_row_.end(), max_rows.begin() + offset);
+        copy(allocation_row_.begin(), allocation_row_.end(), allocation_rows.begin() + offset);
+        copy(need_row_.begin(), need_row_.end(), need_rows.begin() + offset);
+        placed_[record_.id] = 1;
+        processes.push_back(record_);
+        record_seen_ = 0;
+    }
+
+    // Decimal number, converted exactly as strtod would. Plain decimals with
+    // at most 15 significant digits are one division of two exact doubles,
+    // which rounds correctly; anything else is copied to a small buffer for
+    // strtod itself.
+    double ParseDouble(const char* p) {
+        static const double kPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15};
+        const char* q = p;
+        bool negative = q < eol_ && *q == '-';
+        if (negative) q++;
+        uint64_t mantissa = 0;
+        int digits = 0, fraction = -1;
+        for (; q < eol_ && digits <= 15; q++) {
+            if (*q == '.' && fraction < 0) {
+                fraction = 0;
+            } else if (static_cast<unsigned>(*q - '0') < 10) {
+                mantissa = mantissa * 10 + (*q - '0');
+                digits++;
+                if (fraction >= 0) fraction++;
+            } else {
+                break;
+            }
+        }
+        if (q == eol_ && digits > 0 && digits <= 15) {
+            double value = static_cast<double>(mantissa) / kPowers[max(fraction, 0)];
+            return negative ? -value : value;
+        }
+
+        char buffer[64];
+        size_t len = eol_ - p;
+        if (len == 0 || len >= sizeof(buffer)) Fail(p, "expected a number");
+        memcpy(buffer, p, len);
+        buffer[len] = '\0';
+        char* parsed_end;
+        double value = strtod(buffer, &parsed_end);
+        if (parsed_end != buffer + len) Fail(p, "expected a number");
+        return value;
+    }
+
+    void HistoryField() {
+        int key;
+        if (key_ == "pid") key = kPid;
+        else if (key_ == "resources") key = kResources;
+        else if (key_ == "timestamp") key = kTimestamp;
+        else if (key_ == "action") key = kAction;
+        else Fail(key_.data(), "unknown history field '" + string(key_) + "'");
+        if (record_seen_ & key) EndHistory();
+        if (record_seen_ == 0) record_line_ = line_;
+        record_seen_ |= key;
+
+        switch (key) {
+            case kPid:
+                entry_pid_ = ParseInt(value_);
+                ExpectEnd();
+                break;
+            case kResources:
+                ParseRowOf(max_row_, "resources");
+                break;
+            case kTimestamp:
+                entry_time_ = static_cast<time_t>(ParseInt64(value_));
+                ExpectEnd();
+                break;
+            case kAction:
+                if (!ParseHistoryAction(string(value_, eol_), entry_action_)) Fail(value_, "unknown history action");
+                break;
+        }
+    }
+
+    void EndHistory() {
+        if (record_seen_ == 0) return;
+        if (record_seen_ != kAllHistoryKeys) {
+            const char* names[] = {"pid", "resources", "timestamp", "action"};
+            for (int k = 0; k < 4; k++) {
+                if (!(record_seen_ & (1 << k))) {
+                    line_ = record_line_;
+                    Fail(nullptr, string("history entry is missing '") + names[k] + "'");
+                }
+            }
+        }
+        history_pids.push_back(entry_pid_);
+        history_actions.push_back(entry_action_);
+        history_times.push_back(entry_time_);
+        history_rows.insert(history_rows.end(), max_row_.begin(), max_row_.end());
+        record_seen_ = 0;
+    }
+
+    const char* pos_;
+    const char* end_;
+    size_t size_;
+    const char* line_start_;
+    const char* eol_;
+    const char* value_;
+    const char* cursor_;
+    string_view key_;
+    int line_;
+
+    // The record being parsed
+    int record_seen_;
+    int record_line_;
+    process record_;
+    vector<int> max_row_, allocation_row_, need_row_;  // max_row_ also holds history amounts
+    int entry_pid_;
+    HistoryAction entry_action_;
+    time_t entry_time_;
+    vector<char> placed_;
+};
+
+// Replace the state with a parsed one. The caller must hold mtx exclusively.
+void ApplyStateText(const StateTextParser& parsed) {
+    lock_guard<mutex> history_lock(history_mtx);
+    nprocesses = parsed.nprocesses;
+    nresources = parsed.nresources;
+    available = parsed.available;
+    total_resources = parsed.total_resources;
+    processes.resize(nprocesses);
+    for (const process& p : parsed.processes) processes[p.id] = p;
+    const vector<int>* rows[3] = {&parsed.max_rows, &parsed.allocation_rows, &parsed.need_rows};
+    ResourceMatrix* matrices[3] = {&max_matrix, &allocation_matrix, &need_matrix};
+    for (int k = 0; k < 3; k++) {
+        matrices[k]->Reset(nprocesses, nresources);
+        for (int i = 0; i < nprocesses; i++) {
+            copy_n(rows[k]->data() + static_cast<size_t>(i) * nresources, nresources, matrices[k]->Row(i));
+        }
+    }
+
+    request_matrix.Reset(nprocesses, nresources);
+    wait_for_graph.Reset(nprocesses, nresources);
+    state_views.Reset(nprocesses);
+    partitions.Rebuild(processes, max_matrix, allocation_matrix, need_matrix);
+    history.Reset(nresources);
+    historical_need.Reset(nresources);
+    history_stats.Reset(nresources);
+    vector<int> row(nresources);
+    for (size_t k = 0; k < parsed.history_pids.size(); k++) {
+        copy_n(parsed.history_rows.data() + k * nresources, nresources, row.data());
+        history.Append(parsed.history_pids[k], parsed.history_actions[k], row, parsed.history_times[k]);
+        history_stats.Observe(row.data(), nresources);
+    }
+}
+
+thread_local StateTextParser state_text_parser;
+
+// Replace the state with text in the system_state.txt format. The caller
+// must hold mtx exclusively. Throws invalid_argument on malformed input.
+void ReadStateText(const char* data, size_t size) {
+    state_text_parser.Parse(data, size);
+    ApplyStateText(state_text_parser);
+}
+
+// The file is parsed before mtx is taken, so admissions only wait for the
+// state to be swapped in. Throws invalid_argument, prefixed with the file
+// name, on malformed input.
+bool TryLoadConfigFromText(const string& filename) {
+    MappedFile file;
+    if (!file.Open(filename)) return false;
+    try {
+        state_text_parser.Parse(file.data(), file.size());
+    } catch (const invalid_argument& e) {
+        throw invalid_argument(filename + ":" + e.what());
+    }
+    unique_lock<shared_mutex> lock(mtx);
+    ApplyStateText(state_text_parser);
+    TraceStateSnapshot(SnapshotReason::Load);
+    CheckpointReplacedState(SnapshotReason::Load);
+    LogAction("Config", "Loaded from " + filename);
+    return true;
+}
+
+void LoadConfigFromText(const string& filename) {
+    if (!TryLoadConfigFromText(filename)) {
+        cout << RED << "Failed to open config file: " << filename << RESET << endl;
+        return;
+    }
+    cout << GREEN << "Configuration loaded from " << filename << RESET << endl;
+}
+
+// ======================== Binary Snapshot ========================
+// Versioned binary image of the whole state, for restarts that must not wait
+// on the text parser. Fields are in host byte order and every section starts
+// on an 8-byte boundary, so a mapped file is read in place:
+//   header    magic "BSNAP001" | u32 version | u32 header bytes |
+//             i32 nprocesses | i32 nresources | u64 history entries |
+//             u64 history capacity | i32 chain length | u32 wal epoch |
+//             u64 chain bytes | u64 payload bytes
+//   vectors   available, total_resources (i32 x nresources each)
+//   processes i32 id | i32 priority | i32 wait_time | u8 status | 3 pad |
+//             f64 cpu_usage | i64 start_time | i64 end_time
+//   matrices  max, allocation, need, request (i32, nprocesses x nresources
+//             each, without the row padding)
+//   history   per entry i64 timestamp | i32 pid | u8 action | 3 pad, then
+//             the amounts (i32 x nresources per entry), oldest first
+//   chain     every block, in the ledger's record encoding
+//   trailer   u64 XXH64 of everything before it
+// The text format stays the one for people to read and edit.
+const char kSnapshotMagic[9] = "BSNAP001";
+const uint32_t kSnapshotVersion = 1;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_bytes;
+    int32_t nprocesses;
+    int32_t nresources;
+    uint64_t history_entries;
+    uint64_t history_capacity;
+    int32_t chain_length;
+    uint32_t wal_epoch;  // of the log continuing a checkpoint, else 0
+    uint64_t chain_bytes;
+    uint64_t payload_bytes;
+};
+
+struct SnapshotProcess {
+    int32_t id;
+    int32_t priority;
+    int32_t wait_time;
+    uint8_t status;
+    uint8_t pad[3];
+    double cpu_usage;
+    int64_t start_time;
+    int64_t end_time;
+};
+
+struct SnapshotHistoryEntry {
+    int64_t timestamp;
+    int32_t pid;
+    uint8_t action;
+    uint8_t pad[3];
+};
+
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header layout");
+static_assert(sizeof(SnapshotProcess) == 40, "snapshot process layout");
+static_assert(sizeof(SnapshotHistoryEntry) == 16, "snapshot history layout");
+
+size_t SnapshotPadded(size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+// Payload bytes before the chain section for a given shape
+uint64_t SnapshotFixedBytes(uint64_t n, uint64_t m, uint64_t history_entries) {
+    return 2 * SnapshotPadded(m * sizeof(int32_t)) + n * sizeof(SnapshotProcess) +
+           4 * SnapshotPadded(n * m * sizeof(int32_t)) +
+           history_entries * sizeof(SnapshotHistoryEntry) + SnapshotPadded(history_entries * m * sizeof(int32_t));
+}
+
+// Buffered file output that hashes everything it writes
+class SnapshotWriter {
+public:
+    static const size_t kFlushBytes = 1 << 20;
+
+    explicit SnapshotWriter(FILE* file) : file_(file), written_(0) {}
+
+    void Write(const void* data, size_t len) {
+        hasher_.Update(data, len);
+        buffer_.append(static_cast<const char*>(data), len);
+        written_ += len;
+        if (buffer_.size() >= kFlushBytes) Flush();
+    }
+
+    // Zero-fill up to the next 8-byte boundary
+    void Align() {
+        static const char zeros[8] = {};
+        Write(zeros, SnapshotPadded(written_) - written_);
+    }
+
+    // Append the checksum and flush everything to disk
+    bool Finish() {
+        uint64_t checksum = hasher_.Final();
+        buffer_.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+        Flush();
+        fflush(file_);
+#ifdef _WIN32
+        _commit(_fileno(file_));
+#else
+        fsync(fileno(file_));
+#endif
+        return !ferror(file_);
+    }
+
+private:
+    void Flush() {
+        fwrite(buffer_.data(), 1, buffer_.size(), file_);
+        buffer_.clear();
+    }
+
+    FILE* file_;
+    uint64_t written_;
+    string buffer_;
+    XxHash64 hasher_;
+};
+
+// Write the state to filename through a temporary file, so an interrupted
+// save never leaves a truncated snapshot behind. The caller must hold mtx
+// exclusively.
+bool SaveSnapshotLocked(const string& filename, uint32_t wal_epoch, string& error) {
+    lock_guard<mutex> history_lock(history_mtx);
+    string chain;
+    int length;
+    {
+        lock_guard<mutex> chain_lock(chain_mtx);
+        length = chain_length;
+        if (!ledger.ReadRecords(length - 1, chain)) {
+            error = "cannot read the chain back from the ledger";
+            return false;
+        }
+    }
+
+    string temp = filename + ".tmp";
+    FILE* file = fopen(temp.c_str(), "wb");
+    if (!file) {
+        error = "cannot open " + temp;
+        return false;
+    }
+    const size_t m = nresources;
+    SnapshotHeader header = {};
+    memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+    header.version = kSnapshotVersion;
+    header.header_bytes = sizeof(header);
+    header.nprocesses = nprocesses;
+    header.nresources = nresources;
+    header.history_entries = history.size();
+    header.history_capacity = history.capacity();
+    header.chain_length = length;
+    header.wal_epoch = wal_epoch;
+    header.chain_bytes = chain.size();
+    header.payload_bytes = SnapshotFixedBytes(nprocesses, m, history.size()) + chain.size();
+
+    SnapshotWriter out(file);
+    out.Write(&header, sizeof(header));
+    out.Write(available.data(), m * sizeof(int32_t));
+    out.Align();
+    out.Write(total_resources.data(), m * sizeof(int32_t));
+    out.Align();
+    for (const process& p : processes) {
+        SnapshotProcess record = {};
+        record.id = p.id;
+        record.priority = p.priority;
+        record.wait_time = p.wait_time;
+        record.status = p.status;
+        record.cpu_usage = p.cpu_usage;
+        record.start_time = p.start_time;
+        record.end_time = p.end_time;
+        out.Write(&record, sizeof(record));
+    }
+    for (const ResourceMatrix* matrix : {&max_matrix, &allocation_matrix, &need_matrix, &request_matrix}) {
+        for (int i = 0; i < nprocesses; i++) out.Write(matrix->Row(i), m * sizeof(int32_t));
+        out.Align();
+    }
+    for (size_t k = 0; k < history.size(); k++) {
+        AllocationHistory h = history[k];
+        SnapshotHistoryEntry entry = {};
+        entry.timestamp = h.timestamp;
+        entry.pid = h.pid;
+        entry.action = static_cast<uint8_t>(h.action);
+        out.Write(&entry, sizeof(entry));
+    }
+    for (size_t k = 0; k < history.size(); k++) out.Write(history[k].resources, m * sizeof(int32_t));
+    out.Align();
+    out.Write(chain.data(), chain.size());
+    bool ok = out.Finish();
+    ok = fclose(file) == 0 && ok;
+#ifdef _WIN32
+    if (ok) remove(filename.c_str());
+#endif
+    if (!ok || rename(temp.c_str(), filename.c_str()) != 0) {
+        remove(temp.c_str());
+        error = "cannot write " + filename;
+        return false;
+    }
+    LogAction("Snapshot", "Saved " + to_string(nprocesses) + " processes to " + filename);
+    return true;
+}
+
+bool TrySaveSnapshot(const string& filename, string& error) {
+    unique_lock<shared_mutex> lock(mtx);
+    return SaveSnapshotLocked(filename, 0, error);
+}
+
+// Replace the state with a snapshot. The file is checked completely (shape,
+// section sizes, checksum, chain records) before anything is replaced.
+bool TryLoadSnapshot(const string& filename, string& error, uint32_t* wal_epoch) {
+    MappedFile file;
+    if (!file.Open(filename)) {
+        error = "cannot open " + filename;
+        return false;
+    }
+    const char* data = file.data();
+    SnapshotHeader header;
+    if (file.size() < sizeof(header) + sizeof(uint64_t)) {
+        error = filename + " is not a snapshot";
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 || header.header_bytes != sizeof(header)) {
+        error = filename + " is not a snapshot";
+        return false;
+    }
+    if (header.version != kSnapshotVersion) {
+        error = filename + ": unsupported snapshot version " + to_string(header.version);
+        return false;
+    }
+    // The checksum only catches accidental damage, so the capacity is bounded
+    // here like a configured one before the ring is sized from it
+    if (header.history_capacity == 0 || header.history_capacity > HistoryRing::kMaxCapacity) {
+        error = filename + ": history capacity " + to_string(header.history_capacity) + " out of range";
+        return false;
+    }
+    const uint64_t n = header.nprocesses, m = header.nresources;
+    if (header.nprocesses < 0 || header.nresources <= 0 || header.chain_length <= 0 ||
+        header.history_entries > header.history_capacity ||
+        header.payload_bytes != file.size() - sizeof(header) - sizeof(uint64_t) ||
+        header.chain_bytes > header.payload_bytes ||
+        SnapshotFixedBytes(n, m, header.history_entries) != header.payload_bytes - header.chain_bytes) {
+        error = filename + ": section sizes do not match the header";
+        return false;
+    }
+    XxHash64 hasher;
+    hasher.Update(data, file.size() - sizeof(uint64_t));
+    uint64_t checksum;
+    memcpy(&checksum, data + file.size() - sizeof(checksum), sizeof(checksum));
+    if (hasher.Final() != checksum) {
+        error = filename + ": checksum mismatch";
+        return false;
+    }
+
+    const char* pos = data + sizeof(header);
+    const char* available_data = pos;
+    pos += SnapshotPadded(m * sizeof(int32_t));
+    const char* total_data = pos;
+    pos += SnapshotPadded(m * sizeof(int32_t));
+    const char* process_data = pos;
+    pos += n * sizeof(SnapshotProcess);
+    const char* matrix_data[4];
+    for (const char*& matrix : matrix_data) {
+        matrix = pos;
+        pos += SnapshotPadded(n * m * sizeof(int32_t));
+    }
+    const char* entry_data = pos;
+    pos += header.history_entries * sizeof(SnapshotHistoryEntry);
+    const char* amount_data = pos;
+    pos += SnapshotPadded(header.history_entries * m * sizeof(int32_t));
+    // Process ids index the matrices, so each record must hold its own row.
+    for (uint64_t i = 0; i < n; i++) {
+        SnapshotProcess record;
+        memcpy(&record, process_data + i * sizeof(record), sizeof(record));
+        if (static_cast<uint64_t>(record.id) != i || record.status > 1) {
+            error = filename + ": malformed process record " + to_string(i);
+            return false;
+        }
+    }
+    for (uint64_t k = 0; k < header.history_entries; k++) {
+        SnapshotHistoryEntry entry;
+        memcpy(&entry, entry_data + k * sizeof(entry), sizeof(entry));
+        if (entry.action > static_cast<uint8_t>(HistoryAction::Need)) {
+            error = filename + ": malformed history entry " + to_string(k);
+            return false;
+        }
+    }
+
+    unique_lock<shared_mutex> lock(mtx);
+    {
+        lock_guard<mutex> chain_lock(chain_mtx);
+        deque<Block> window;
+        if (!ledger.Restore("blockchain.ledger", pos, header.chain_bytes, header.chain_length, kChainWindow, window)) {
+            error = filename + ": malformed chain section";
+            return false;
+        }
+        blockchain.swap(window);
+        chain_length = header.chain_length;
+        chain_verifier.Reset();
+    }
+
+    unique_lock<mutex> history_lock(history_mtx);
+    nprocesses = header.nprocesses;
+    nresources = header.nresources;
+    available.resize(m);
+    memcpy(available.data(), available_data, m * sizeof(int32_t));
+    total_resources.resize(m);
+    memcpy(total_resources.data(), total_data, m * sizeof(int32_t));
+    processes.resize(n);
+    for (uint64_t i = 0; i < n; i++) {
+        SnapshotProcess record;
+        memcpy(&record, process_data + i * sizeof(record), sizeof(record));
+        process& p = processes[i];
+        p.id = record.id;
+        p.priority = record.priority;
+        p.wait_time = record.wait_time;
+        p.status = record.status != 0;
+        p.cpu_usage = record.cpu_usage;
+        p.start_time = record.start_time;
+        p.end_time = record.end_time;
+    }
+    ResourceMatrix* matrices[4] = {&max_matrix, &allocation_matrix, &need_matrix, &request_matrix};
+    for (int k = 0; k < 4; k++) {
+        matrices[k]->Reset(nprocesses, nresources);
+        for (int i = 0; i < nprocesses; i++) {
+            memcpy(matrices[k]->Row(i), matrix_data[k] + i * m * sizeof(int32_t), m * sizeof(int32_t));
+        }
+    }
+
+    wait_for_graph.Reset(nprocesses, nresources);
+    state_views.Reset(nprocesses);
+    partitions.Rebuild(processes, max_matrix, allocation_matrix, need_matrix);
+    history.SetCapacity(header.history_capacity);
+    history.Reset(nresources);
+    historical_need.Reset(nresources);
+    history_stats.Reset(nresources);
+    vector<int> row(m);
+    for (uint64_t k = 0; k < header.history_entries; k++) {
+        SnapshotHistoryEntry entry;
+        memcpy(&entry, entry_data + k * sizeof(entry), sizeof(entry));
+        memcpy(row.data(), amount_data + k * m * sizeof(int32_t), m * sizeof(int32_t));
+        history.Append(entry.pid, static_cast<HistoryAction>(entry.action), row, entry.timestamp);
+        history_stats.Observe(row.data(), nresources);
+    }
+    history_lock.unlock();
+    if (wal_epoch) *wal_epoch = header.wal_epoch;
+    TraceStateSnapshot(SnapshotReason::Load);
+    CheckpointReplacedState(SnapshotReason::Load);
+    LogAction("Snapshot", "Loaded " + to_string(nprocesses) + " processes from " + filename);
+    return true;
+}
+
+void SaveStateToFile(const string& filename) {
+    string error;
+    if (!TrySaveSnapshot(filename, error)) {
+        cout << RED << "Snapshot not saved: " << error << RESET << endl;
+        return;
+    }
+    cout << GREEN << "Snapshot saved to " << filename << RESET << endl;
+}
+
+void LoadStateFromFile(const string& filename) {
+    string error;
+    auto start = chrono::steady_clock::now();
+    if (!TryLoadSnapshot(filename, error)) {
+        cout << RED << "Snapshot not loaded: " << error << RESET << endl;
+        return;
+    }
+    double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << GREEN << "Snapshot loaded from " << filename << " in " << fixed << setprecision(2) << ms << " ms"
+         << RESET << endl;
+}
+
+void ConfigureLogging() {
+    int level, interval;
+    cout << "Current level: " << LogLevelName(logger.Level()) << ", flush interval: "
+         << logger.FlushInterval() << " ms, dropped: " << logger.Dropped() << endl;
+    cout << "Enter minimum level (0=Debug 1=Info 2=Warn 3=Error): ";
+    cin >> level;
+    cout << "Enter flush interval (ms): ";
+    cin >> interval;
+    if (level < 0 || level > 3 || interval <= 0) {
+        cout << RED << "Invalid logging configuration" << RESET << endl;
+        return;
+    }
+    logger.SetLevel(static_cast<LogLevel>(level));
+    logger.SetFlushInterval(interval);
+    cout << GREEN << "Logging level set to " << LogLevelName(logger.Level()) << ", flush every "
+         << interval << " ms" << RESET << endl;
+    LogMessage(LogLevel::Warn, "Logging", "Configuration changed");
+}
+
+void DisplaySimulationStats() {
+    shared_lock<shared_mutex> lock(mtx);
+    cout << "\n" << BOLD << BLUE << "Simulation Statistics:" << RESET << endl;
+    cout << "Requests Processed: " << sim_stats.requests_processed << endl;
+    cout << "Deadlocks Detected: " << sim_stats.deadlocks_detected << endl;
+    cout << "Deadlocks Resolved: " << sim_stats.deadlocks_resolved << endl;
+    cout << "Total Simulation Cycles: " << sim_stats.total_cycles << endl;
+    if (load_generator.Running()) {
+        LoadTotals totals = load_generator.Totals();
+        cout << "Load generator: running, " << totals.ops << " operations in " << fixed << setprecision(2)
+             << totals.seconds << " s" << endl;
+    }
+    cout << endl;
+    PrintLatencyTable();
+    LogAction("Stats", "Displayed simulation statistics");
+}
+
+void UpdatePriorityQueue() {
+    shared_lock<shared_mutex> lock(mtx);
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
+    for (int i = 0; i < nprocesses; i++) {
+        if (!processes[i].status) {
+            pq.push({processes[i].priority, i});
+        }
+    }
+    cout << "\n" << BOLD << MAGENTA << "Priority Queue Updated:" << RESET << endl;
+    while (!pq.empty()) {
+        cout << "P" << pq.top().second << " (Priority: " << pq.top().first << ")" << endl;
+        pq.pop();
+    }
+    LogAction("PriorityQueue", "Updated and displayed");
+}
+
+void ValidateInput(int pid, const vector<int>& vec, const string& type) {
+    if (pid < 0 || pid >= nprocesses) {
+        cout << RED << "Invalid process ID: " << pid << RESET << endl;
+        throw invalid_argument("Invalid process ID");
+    }
+    if (vec.size() != static_cast<size_t>(nresources)) {
+        cout << RED << "Invalid " << type << " size: expected " << nresources << RESET << endl;
+        throw invalid_argument("Invalid " + type + " size");
+    }
+    for (int v : vec) {
+        if (v < 0) {
+            cout << RED << "Negative values not allowed in " << type << RESET << endl;
+            throw invalid_argument("Negative values in " + type);
+        }
+    }
+}
+
+void ResetSystemState() {
+    unique_lock<shared_mutex> lock(mtx);
+    processes.clear();
+    available.assign(nresources, 10);
+    total_resources = available;
+    nprocesses = 5;
+    processes.resize(nprocesses);
+    max_matrix.Reset(nprocesses, nresources);
+    allocation_matrix.Reset(nprocesses, nresources);
+    need_matrix.Reset(nprocesses, nresources);
+    request_matrix.Reset(nprocesses, nresources);
+    for (int i = 0; i < nprocesses; i++) {
+        processes[i].id = i;
+        fill(max_matrix.Row(i), max_matrix.Row(i) + nresources, 5);
+        fill(need_matrix.Row(i), need_matrix.Row(i) + nresources, 5);
+        processes[i].status = false;
+        processes[i].priority = rand() % 5 + 1;
+        processes[i].cpu_usage = (rand() % 50 + 10) / 100.0;
+        processes[i].wait_time = 0;
+    }
+    wait_for_graph.Reset(nprocesses, nresources);
+    state_views.Reset(nprocesses);
+    partitions.Rebuild(processes, max_matrix, allocation_matrix, need_matrix);
+    sim_stats.requests_processed = 0;
+    sim_stats.deadlocks_detected = 0;
+    sim_stats.deadlocks_resolved = 0;
+    sim_stats.total_cycles = 0;
+    latency.Reset();
+    {
+        lock_guard<mutex> history_lock(history_mtx);
+        history.Reset(nresources);
+        historical_need.Reset(nresources);
+        history_stats.Reset(nresources);
+    }
+    InitializeBlockchain();
+    TraceStateSnapshot(SnapshotReason::Reset);
+    CheckpointReplacedState(SnapshotReason::Reset);
+    LogAction("Initialize", "System reset to default state");
+}
+
+void InitializeSystem() {
+    ResetSystemState();
+    cout << GREEN << "System initialized with default configuration" << RESET << endl;
+}
+
+// ======================== Library API ========================
+
+void BankerSystem::Reset() { ResetSystemState(); }
+
+// A malformed file is reported as file:line:column: message, not thrown
+bool BankerSystem::LoadConfig(const string& filename, string* error) {
+    string message;
+    bool ok = false;
+    try {
+        ok = TryLoadConfigFromText(filename);
+        if (!ok) message = "cannot open " + filename;
+    } catch (const invalid_argument& e) {
+        message = e.what();
+    }
+    if (error) *error = message;
+    return ok;
+}
+
+bool BankerSystem::ExportConfig(const string& filename) { return TryExportToText(filename); }
+
+bool BankerSystem::SaveSnapshot(const string& filename, string* error) {
+    string message;
+    bool ok = TrySaveSnapshot(filename, message);
+    if (error) *error = message;
+    return ok;
+}
+
+bool BankerSystem::LoadSnapshot(const string& filename, string* error) {
+    string message;
+    bool ok = TryLoadSnapshot(filename, message);
+    if (error) *error = message;
+    return ok;
+}
+
+// Checkpoint of the write-ahead log, if it is open
+bool BankerSystem::Checkpoint(string* error) {
+    string message;
+    bool ok = TryCheckpoint(message);
+    if (error) *error = message;
+    return ok;
+}
+
+// Immutable copy of the current state; cheap when nothing changed since the last call
+shared_ptr<const StateView> BankerSystem::View() {
+    return state_views.Acquire(*this);
+}
+
+// Declare resource partitions, each a list of resource types; an empty list turns them off
+bool BankerSystem::SetPartitions(const vector<vector<int>>& groups, string* error) {
+    string message;
+    bool ok = TryConfigurePartitions(groups, message);
+    if (error) *error = message;
+    return ok;
+}
+
+// Safety check of the current state; the safe sequence is copied out if requested
+bool BankerSystem::IsSafe(vector<int>* sequence) {
+    shared_lock<shared_mutex> lock(mtx);
+    bool safe = ::IsSafe();
+    if (sequence) *sequence = seq;
+    return safe;
+}
+
+AdmissionOutcome BankerSystem::Request(int pid, const vector<int>& request) { return TryRequest(pid, request); }
+
+vector<AdmissionOutcome> BankerSystem::RequestBatch(const vector<PendingRequest>& batch) {
+    return RequestResourcesBatch(batch);
+}
+
+bool BankerSystem::Release(int pid, const vector<int>& release) { return TryRelease(pid, release); }
+
+int BankerSystem::AddProcess(int max_resources, int priority, const vector<int>& resources) {
+    return TryAddProcess(max_resources, priority, resources);
+}
+
+bool BankerSystem::RemoveProcess(int pid) { return TryRemoveProcess(pid); }
+
+vector<int> BankerSystem::FindDeadlockCycle() { return ::FindDeadlockCycle(); }
+
+vector<vector<int>> BankerSystem::FindDeadlockedSets() { return ::FindDeadlockedSets(); }
+
+vector<int> BankerSystem::FindDeadlockedProcesses() { return ::FindDeadlockedProcesses(); }
+
+RecoveryReport BankerSystem::RecoverDeadlock() { return TryRecoverDeadlock(); }
+
+bool BankerSystem::VerifyChain(int* first_bad) {
+    int bad = 0;
+    bool valid = chain_verifier.VerifyFull(ChainLength(), max(1u, thread::hardware_concurrency()), bad);
+    if (first_bad) *first_bad = bad;
+    return valid;
+}
+
+int BankerSystem::ProcessCount() {
+    shared_lock<shared_mutex> lock(mtx);
+    return nprocesses;
+}
+
+vector<int> BankerSystem::Available() {
+    shared_lock<shared_mutex> lock(mtx);
+    vector<int> free_units;
+    ReadConsistent([&] { free_units = available; });
+    return free_units;
+}
+
+// ======================== Trace Replay ========================
+
+// Snapshot the current state into the trace. The caller must hold mtx
+// exclusively.
+void TraceStateSnapshot(SnapshotReason reason) {
+    if (!trace.Recording()) return;
+    ostringstream text;
+    WriteStateText(text, false);
+    trace.RecordSnapshot(reason, text.str());
+}
+
+struct TraceRecord {
+    uint64_t t_ns;
+    TraceOp op;
+    int pid;
+    int outcome;
+    vector<int> values;  // amounts, or the add arguments for AddProcess
+    string state_text;   // Snapshot only
+};
+
+bool ReadTraceFile(const string& path, vector<TraceRecord>& records, string& error) {
+    ifstream file(path, ios::binary);
+    if (!file.is_open()) {
+        error = "Cannot open trace " + path;
+        return false;
+    }
+    file.seekg(0, ios::end);
+    const uint64_t file_size = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    char magic[8];
+    if (!file.read(magic, 8) || memcmp(magic, TraceRecorder::kMagic, 8) != 0) {
+        error = path + " is not a trace file";
+        return false;
+    }
+    records.clear();
+    while (true) {
+        uint64_t t_ns;
+        int32_t pid;
+        uint32_t count;
+        uint8_t op, outcome;
+        if (!file.read(reinterpret_cast<char*>(&t_ns), sizeof(t_ns))) break;
+        file.read(reinterpret_cast<char*>(&pid), sizeof(pid));
+        file.read(reinterpret_cast<char*>(&count), sizeof(count));
+        file.read(reinterpret_cast<char*>(&op), sizeof(op));
+        file.read(reinterpret_cast<char*>(&outcome), sizeof(outcome));
+        // The payload must fit in what is left of the file before it is sized from count
+        uint64_t payload = uint64_t(count) * (op == static_cast<uint8_t>(TraceOp::Snapshot) ? 1 : sizeof(int32_t));
+        if (!file || op > static_cast<uint8_t>(TraceOp::Preempt) ||
+            payload > file_size - static_cast<uint64_t>(file.tellg())) {
+            error = path + ": truncated or corrupt record " + to_string(records.size());
+            return false;
+        }
+        TraceRecord r;
+        r.t_ns = t_ns;
+        r.op = static_cast<TraceOp>(op);
+        r.pid = pid;
+        r.outcome = outcome;
+        if (r.op == TraceOp::Snapshot) {
+            r.state_text.resize(count);
+            file.read(&r.state_text[0], count);
+        } else {
+            r.values.resize(count);
+            file.read(reinterpret_cast<char*>(r.values.data()), count * sizeof(int32_t));
+        }
+        if (!file) {
+            error = path + ": truncated record " + to_string(records.size());
+            return false;
+        }
+        records.push_back(move(r));
+    }
+    if (records.empty() || records[0].op != TraceOp::Snapshot) {
+        error = path + " does not start with a state snapshot";
+        return false;
+    }
+    return true;
+}
+
+struct ReplayReport {
+    size_t records;
+    size_t operations;
+    size_t divergent;   // operations whose outcome differs from the recording
+    double seconds;
+    string error;       // set when a malformed snapshot record stopped the replay
+};
+
+// Drive the allocator from a recorded trace through the quiet Try* paths,
+// either as fast as possible or at the recorded timing. Snapshots replace
+// the whole state, so a replay of a complete recording starts from the
+// state the recording started from. A divergent outcome means the allocator
+// no longer decides the same way on the same input. Traces carry no
+// checksum, so a snapshot that does not parse stops the replay with an
+// error in the report; the state is left as it was before that record.
+ReplayReport ReplayTrace(const vector<TraceRecord>& records, bool timed) {
+    ReplayReport report = {records.size(), 0, 0, 0.0, ""};
+    auto start = chrono::steady_clock::now();
+    for (size_t k = 0; k < records.size() && report.error.empty(); k++) {
+        const TraceRecord& r = records[k];
+        if (timed) this_thread::sleep_until(start + chrono::nanoseconds(r.t_ns));
+        int result = 0;
+        switch (r.op) {
+            case TraceOp::Snapshot: {
+                unique_lock<shared_mutex> lock(mtx);
+                try {
+                    ReadStateText(r.state_text.data(), r.state_text.size());
+                } catch (const invalid_argument& e) {
+                    report.error = "record " + to_string(k) + ": snapshot:" + e.what();
+                    continue;
+                }
+                CheckpointReplacedState(static_cast<SnapshotReason>(r.outcome));
+                continue;
+            }
+            case TraceOp::Request:
+                result = static_cast<int>(TryRequest(r.pid, r.values));
+                break;
+            case TraceOp::Release:
+                result = TryRelease(r.pid, r.values);
+                break;
+            case TraceOp::AddProcess:
+                // The recorded pid is the one the process was given
+                result = r.values.size() >= 3 &&
+                         TryAddProcess(r.values[0], r.values[1], vector<int>(r.values.begin() + 3, r.values.end()),
+                                       r.values[2]) == r.pid &&
+                         r.pid >= 0;
+                break;
+            case TraceOp::RemoveProcess:
+                result = TryRemoveProcess(r.pid);
+                break;
+            case TraceOp::Preempt:
+                result = TryPreempt(r.pid, r.values);
+                break;
+        }
+        report.operations++;
+        if (result != r.outcome) report.divergent++;
+    }
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+void PrintReplayReport(const ReplayReport& report, const string& path) {
+    cout << "Replayed " << report.operations << " operations (" << report.records << " records) from "
+         << path << " in " << fixed << setprecision(3) << report.seconds * 1000 << " ms ("
+         << setprecision(0) << (report.seconds > 0 ? report.operations / report.seconds : 0.0)
+         << " ops/s)" << endl;
+    if (!report.error.empty()) {
+        cout << RED << "Replay stopped at " << path << ": " << report.error << RESET << endl;
+    } else if (report.divergent == 0) {
+        cout << GREEN << "All outcomes match the recording" << RESET << endl;
+    } else {
+        cout << YELLOW << report.divergent << " outcomes differ from the recording" << RESET << endl;
+    }
+}
+
+void TraceMenu() {
+    if (trace.Recording()) {
+        uint64_t records = trace.Stop();
+        cout << GREEN << "Trace recording stopped, " << records << " records written" << RESET << endl;
+        LogAction("Trace", "Recording stopped after " + to_string(records) + " records");
+        return;
+    }
+    string filename;
+    cout << "Enter trace file name: ";
+    cin >> filename;
+    bool started;
+    {
+        unique_lock<shared_mutex> lock(mtx);
+        ostringstream text;
+        WriteStateText(text, false);
+        started = trace.Start(filename, text.str());
+    }
+    if (!started) {
+        cout << RED << "Cannot open trace file " << filename << RESET << endl;
+        return;
+    }
+    cout << GREEN << "Recording trace to " << filename << RESET << endl;
+    LogAction("Trace", "Recording to " + filename);
+}
+
+void ReplayTraceMenu() {
+    if (trace.Recording() || load_generator.Running()) {
+        cout << YELLOW << "Stop trace recording and the simulation before replaying" << RESET << endl;
+        return;
+    }
+    string filename;
+    int mode;
+    cout << "Enter trace file name: ";
+    cin >> filename;
+    cout << "Enter mode (0=as fast as possible 1=original timing): ";
+    cin >> mode;
+
+    vector<TraceRecord> records;
+    string error;
+    if (!ReadTraceFile(filename, records, error)) {
+        cout << RED << error << RESET << endl;
+        return;
+    }
+    ReplayReport report = ReplayTrace(records, mode == 1);
+    PrintReplayReport(report, filename);
+    if (!report.error.empty()) {
+        LogAction("Trace", "Replay of " + filename + " stopped: " + report.error);
+        return;
+    }
+    LogAction("Trace", "Replayed " + filename + ", " + to_string(report.divergent) + " divergent outcomes");
+}
+
+// ======================== Crash Recovery ========================
+// The interactive program keeps its state in banker.ckpt (the checkpoint, a
+// binary snapshot tagged with a log epoch) and banker.wal (every operation
+// since). A checkpoint is taken when the log outgrows its threshold, when
+// the state is replaced wholesale, and on request; recovery at startup
+// loads the checkpoint and replays the log records of its epoch.
+
+// Save the checkpoint for the next epoch and start its log. The caller must
+// hold mtx exclusively and no other lock.
+bool CheckpointLocked(string& error) {
+    if (!wal.Enabled()) {
+        error = "the write-ahead log is not open";
+        return false;
+    }
+    uint32_t epoch = wal.Epoch() + 1;
+    if (!SaveSnapshotLocked(wal.CheckpointPath(), epoch, error)) return false;
+    if (!wal.Rotate(epoch)) {
+        error = "cannot start " + wal.Path();
+        return false;
+    }
+    LogAction("WAL", "Checkpoint " + to_string(epoch) + " of " + to_string(nprocesses) + " processes");
+    return true;
+}
+
+bool TryCheckpoint(string& error) {
+    unique_lock<shared_mutex> lock(mtx);
+    return CheckpointLocked(error);
+}
+
+// A reset or load replaces the state wholesale, which the log cannot express
+// as operations, so it starts a new checkpoint. Should that fail, the log
+// gets the state text instead, which replays without the chain and history.
+// The caller must hold mtx exclusively and no other lock.
+void CheckpointReplacedState(SnapshotReason reason) {
+    if (!wal.Enabled()) return;
+    string error;
+    if (CheckpointLocked(error)) return;
+    LogMessage(LogLevel::Error, "WAL", error);
+    ostringstream text;
+    WriteStateText(text, false);
+    uint64_t lsn = wal.AppendSnapshot(reason, text.str());
+    if (lsn != 0) wal_last_lsn = lsn;
 }
 
-void DetectDeadlockCycle() {
-    cout << "\n" << BOLD << RED << "Deadlock Cycle Detection:" << RESET << endl;
-    vector<vector<int>> graph(nprocesses, vector<int>(nresources, 0));
-    vector<bool> visited(nprocesses, false);
-    vector<bool> in_stack(nprocesses, false);
+WalCommit::~WalCommit() {
+    if (wal_last_lsn == start_) return;
+    if (wal.Synchronous()) wal.WaitDurable(wal_last_lsn);
+    if (!wal.TakeCheckpointDue()) return;
+    string error;
+    if (!TryCheckpoint(error)) {
+        LogMessage(LogLevel::Error, "WAL", error);
+        wal.PostponeCheckpoint();
+    }
+}
 
-    // Build resource allocation graph
-    for (int i = 0; i < nprocesses; i++) {
-        if (!processes[i].status) {
-            for (int j = 0; j < nresources; j++) {
-                if (processes[i].Need[j] > 0 && processes[i].Need[j] > available[j]) {
-                    graph[i][j] = 1; // Process i needs resource j
-                }
-            }
+// Decode the records of a log up to the first torn or corrupt one;
+// torn_bytes is what is left of the file after it
+bool ReadWalFile(const string& path, uint32_t& epoch, vector<TraceRecord>& records, uint64_t& torn_bytes,
+                 string& error) {
+    MappedFile file;
+    if (!file.Open(path)) {
+        error = "cannot open " + path;
+        return false;
+    }
+    const char* data = file.data();
+    if (file.size() < WriteAheadLog::kHeaderBytes || memcmp(data, WriteAheadLog::kMagic, 8) != 0) {
+        error = path + " is not a write-ahead log";
+        return false;
+    }
+    memcpy(&epoch, data + 8, sizeof(epoch));
+    records.clear();
+    size_t pos = WriteAheadLog::kHeaderBytes;
+    while (file.size() - pos >= WriteAheadLog::kRecordHeaderBytes) {
+        uint32_t len, checksum;
+        memcpy(&len, data + pos, sizeof(len));
+        memcpy(&checksum, data + pos + sizeof(len), sizeof(checksum));
+        if (len < WriteAheadLog::kBodyHeaderBytes ||
+            len > file.size() - pos - WriteAheadLog::kRecordHeaderBytes) {
+            break;
+        }
+        const char* body = data + pos + WriteAheadLog::kRecordHeaderBytes;
+        XxHash64 hasher;
+        hasher.Update(body, len);
+        if (static_cast<uint32_t>(hasher.Final()) != checksum) break;
+
+        int32_t pid;
+        uint32_t count;
+        uint8_t op = static_cast<uint8_t>(body[8]), outcome = static_cast<uint8_t>(body[9]);
+        memcpy(&pid, body, sizeof(pid));
+        memcpy(&count, body + 4, sizeof(count));
+        size_t payload = len - WriteAheadLog::kBodyHeaderBytes;
+        const char* payload_data = body + WriteAheadLog::kBodyHeaderBytes;
+        bool is_snapshot = op == static_cast<uint8_t>(TraceOp::Snapshot);
+        if (op > static_cast<uint8_t>(TraceOp::Preempt) ||
+            payload != (is_snapshot ? count : static_cast<size_t>(count) * sizeof(int32_t))) {
+            break;
+        }
+        TraceRecord r;
+        r.t_ns = 0;
+        r.op = static_cast<TraceOp>(op);
+        r.pid = pid;
+        r.outcome = outcome;
+        if (is_snapshot) {
+            r.state_text.assign(payload_data, payload);
+        } else {
+            r.values.resize(count);
+            memcpy(r.values.data(), payload_data, payload);
         }
+        records.push_back(move(r));
+        pos += WriteAheadLog::kRecordHeaderBytes + len;
     }
+    torn_bytes = file.size() - pos;
+    return true;
+}
 
-    // DFS to detect cycles
-    bool cycle_found = false;
-    vector<int> cycle;
+struct WalRecoveryReport {
+    bool checkpoint;      // a checkpoint was found and loaded
+    uint32_t epoch;       // of that checkpoint
+    bool stale_log;       // the log predates the checkpoint, which covers it
+    size_t operations;    // log records replayed
+    size_t divergent;     // replayed outcomes that differ from the logged ones
+    uint64_t torn_bytes;  // discarded from the end of the log
+    double seconds;
+};
 
-    function<void(int, vector<int>&)> dfs = [&](int v, vector<int>& path) {
-        if (cycle_found) return;
-        visited[v] = true;
-        in_stack[v] = true;
-        path.push_back(v);
+bool FileExists(const string& path) {
+    ifstream file(path, ios::binary);
+    return file.is_open();
+}
 
-        for (int j = 0; j < nresources; j++) {
-            if (graph[v][j]) {
-                for (int u = 0; u < nprocesses; u++) {
-                    if (!processes[u].status && processes[u].Allocation[j] > 0) {
-                        if (!visited[u]) {
-                            dfs(u, path);
-                        } else if (in_stack[u]) {
-                            cycle_found = true;
-                            cycle = path;
-                            cycle.push_back(u);
-                            return;
-                        }
-                    }
+// Recover the state from base.ckpt and base.wal, if there is a checkpoint,
+// then save a fresh checkpoint and log from it. Nothing is overwritten when
+// either file cannot be used, so a damaged pair can still be inspected.
+bool TryOpenWriteAheadLog(const string& base, WalRecoveryReport& report, string& error) {
+    report = WalRecoveryReport();
+    auto start = chrono::steady_clock::now();
+    const string checkpoint = base + ".ckpt", log = base + ".wal";
+    uint32_t epoch = 0;
+    if (FileExists(checkpoint)) {
+        if (!TryLoadSnapshot(checkpoint, error, &epoch)) return false;
+        report.checkpoint = true;
+        report.epoch = epoch;
+        if (FileExists(log)) {
+            vector<TraceRecord> records;
+            uint32_t log_epoch;
+            if (!ReadWalFile(log, log_epoch, records, report.torn_bytes, error)) return false;
+            if (log_epoch > epoch) {
+                error = log + " continues checkpoint " + to_string(log_epoch) + ", but " + checkpoint +
+                        " is checkpoint " + to_string(epoch);
+                return false;
+            }
+            if (log_epoch == epoch) {
+                ReplayReport replay = ReplayTrace(records, false);
+                if (!replay.error.empty()) {
+                    error = log + ": " + replay.error;
+                    return false;
                 }
+                report.operations = replay.operations;
+                report.divergent = replay.divergent;
+            } else {
+                report.stale_log = true;
             }
         }
-
-        in_stack[v] = false;
-        path.pop_back();
-    };
-
-    for (int i = 0; i < nprocesses; i++) {
-        if (!visited[i] && !processes[i].status) {
-            vector<int> path;
-            dfs(i, path);
-            if (cycle_found) break;
-        }
+    } else if (FileExists(log)) {
+        error = log + " has no checkpoint " + checkpoint;
+        return false;
     }
 
-    if (cycle_found) {
-        cout << RED << "Deadlock cycle detected: ";
-        for (size_t i = 0; i < cycle.size(); i++) {
-            cout << "P" << cycle[i];
-            if (i < cycle.size() - 1) cout << " -> ";
-        }
-        cout << RESET << endl;
-        sim_stats.deadlocks_detected++;
-    } else {
-        cout << GREEN << "No deadlock cycle detected" << RESET << endl;
+    unique_lock<shared_mutex> lock(mtx);
+    if (!SaveSnapshotLocked(checkpoint, epoch + 1, error)) return false;
+    if (!wal.Open(base, epoch + 1)) {
+        error = "cannot start " + log;
+        return false;
     }
-    LogAction("DeadlockCycle", cycle_found ? "Cycle detected" : "No cycle detected");
+    report.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    LogAction("WAL", "Logging to " + log + " from checkpoint " + to_string(epoch + 1));
+    return true;
 }
 
-void ExportToText() {
-    ofstream file("system_state.txt");
-    if (!file.is_open()) {
-        cout << RED << "Failed to open file for export: system_state.txt" << RESET << endl;
+void OpenWriteAheadLog(const string& base) {
+    WalRecoveryReport report;
+    string error;
+    if (!TryOpenWriteAheadLog(base, report, error)) {
+        cout << RED << "Write-ahead log disabled: " << error << RESET << endl;
+        LogMessage(LogLevel::Error, "WAL", error);
         return;
     }
-
-    file << "nprocesses: " << nprocesses << "\n";
-    file << "nresources: " << nresources << "\n";
-    file << "available: ";
-    for (int a : available) file << a << " ";
-    file << "\n";
-    file << "total_resources: ";
-    for (int t : total_resources) file << t << " ";
-    file << "\n";
-
-    file << "processes:\n";
-    for (const auto& p : processes) {
-        file << "id: " << p.id << "\n";
-        file << "Max: ";
-        for (int m : p.Max) file << m << " ";
-        file << "\nAllocation: ";
-        for (int a : p.Allocation) file << a << " ";
-        file << "\nNeed: ";
-        for (int n : p.Need) file << n << " ";
-        file << "\nstatus: " << (p.status ? "true" : "false") << "\n";
-        file << "priority: " << p.priority << "\n";
-        file << "cpu_usage: " << fixed << setprecision(2) << p.cpu_usage << "\n";
-        file << "wait_time: " << p.wait_time << "\n";
-    }
-
-    file << "history:\n";
-    for (const auto& h : history) {
-        file << "pid: " << h.pid << "\n";
-        file << "resources: ";
-        for (int r : h.resources) file << r << " ";
-        file << "\ntimestamp: " << h.timestamp << "\n";
-        file << "action: " << h.action << "\n";
+    if (!report.checkpoint) {
+        cout << GREEN << "Write-ahead log started at " << wal.Path() << RESET << endl;
+        return;
     }
-
-    file.close();
-    cout << GREEN << "System state exported to system_state.txt" << RESET << endl;
-    LogAction("Export", "System state exported to text");
+    cout << GREEN << "Recovered checkpoint " << report.epoch << " and " << report.operations
+         << " logged operations in " << fixed << setprecision(1) << report.seconds * 1000 << " ms" << RESET << endl;
+    if (report.stale_log) {
+        cout << YELLOW << "The log predates the checkpoint and was not replayed" << RESET << endl;
+    }
+    if (report.torn_bytes > 0) {
+        cout << YELLOW << "Discarded " << report.torn_bytes << " bytes of incomplete log tail" << RESET << endl;
+    }
+    if (report.divergent > 0) {
+        cout << YELLOW << report.divergent << " replayed outcomes differ from the log" << RESET << endl;
+    }
+    LogAction("WAL", "Recovered " + to_string(report.operations) + " operations, " +
+                     to_string(report.divergent) + " divergent");
 }
 
-void DisplayProcessStatus() {
-    cout << "\n" << BOLD << CYAN << "Process Status Monitor:" << RESET << endl;
-    cout << "PID\tStatus\tCPU Usage\tWait Time\tPriority\n";
-    for (const auto& p : processes) {
-        cout << "P" << p.id << "\t" << (p.status ? "Done" : "Active") << "\t"
-             << fixed << setprecision(2) << p.cpu_usage * 100 << "%\t"
-             << p.wait_time << "s\t" << p.priority << endl;
+void ConfigureWriteAheadLog() {
+    if (!wal.Enabled()) {
+        cout << YELLOW << "The write-ahead log is not open" << RESET << endl;
+        return;
     }
-    LogAction("Status", "Displayed process status");
+    uint64_t records, durable, bytes;
+    wal.Status(records, durable, bytes);
+    cout << "Log " << wal.Path() << " continues checkpoint " << wal.Epoch() << " (" << wal.CheckpointPath()
+         << "): " << records << " records, " << durable << " durable, " << bytes << " bytes" << endl;
+    cout << "Current mode: " << (wal.Synchronous() ? "wait for fsync" : "background fsync")
+         << ", checkpoint every " << wal.CheckpointBytes() / 1024 << " KB of log" << endl;
+    int mode;
+    long long kilobytes;
+    cout << "Enter durability (0=wait for fsync 1=background fsync): ";
+    cin >> mode;
+    cout << "Enter checkpoint threshold (KB of log): ";
+    cin >> kilobytes;
+    if ((mode != 0 && mode != 1) || kilobytes <= 0) {
+        cout << RED << "Invalid write-ahead log configuration" << RESET << endl;
+        return;
+    }
+    wal.SetSynchronous(mode == 0);
+    wal.SetCheckpointBytes(static_cast<uint64_t>(kilobytes) * 1024);
+    string error;
+    if (!TryCheckpoint(error)) {
+        cout << RED << "Checkpoint failed: " << error << RESET << endl;
+        return;
+    }
+    cout << GREEN << "Write-ahead log updated; checkpoint " << wal.Epoch() << " saved to " << wal.CheckpointPath()
+         << RESET << endl;
+    LogAction("WAL", string("Mode ") + (mode == 0 ? "sync" : "async") + ", checkpoint every " +
+                     to_string(kilobytes) + " KB");
 }
 
-void LoadConfigFromText(const string& filename) {
+// ======================== Batch Driver ========================
+// Replays a command file against banker without the menu:
+//   ./banker --batch commands.txt [--results results.txt]
+// One command per line; blank lines and lines starting with '#' are skipped.
+//   request <pid> <r0> <r1> ...     release <pid> <r0> <r1> ...
+//   add <max> <priority>            remove <pid>
+//   safe    detect    reset    load <file>    export <file>
+// The whole file is parsed before anything runs, so a syntax error aborts
+// the replay without touching the state. Results are only formatted after
+// the timed replay.
+
+enum class BatchOp { Request, Release, Add, Remove, Safe, Detect, Reset, Load, Export, Save, Restore };
+
+struct BatchCommand {
+    BatchOp op;
+    int line;
+    int pid;   // pid for request/release/remove, max for add
+    int priority;
+    vector<int> amounts;
+    string path;
+};
+
+bool ParseBatchFile(const string& filename, vector<BatchCommand>& commands, string& error) {
     ifstream file(filename);
     if (!file.is_open()) {
-        cout << RED << "Failed to open config file: " << filename << RESET << endl;
-        return;
+        error = "cannot open " + filename;
+        return false;
     }
-
     string line;
-    getline(file, line);
-    nprocesses = stoi(line.substr(line.find(": ") + 2));
-    getline(file, line);
-    nresources = stoi(line.substr(line.find(": ") + 2));
-
-    getline(file, line);
-    stringstream ss(line.substr(line.find(": ") + 2));
-    available.clear();
-    int val;
-    while (ss >> val) available.push_back(val);
-
-    getline(file, line);
-    ss.clear();
-    ss.str(line.substr(line.find(": ") + 2));
-    total_resources.clear();
-    while (ss >> val) total_resources.push_back(val);
-
-    processes.clear();
-    getline(file, line); // "processes:"
-    while (getline(file, line) && line != "history:") {
-        process p;
-        p.id = stoi(line.substr(line.find(": ") + 2));
-        getline(file, line);
-        ss.clear();
-        ss.str(line.substr(line.find(": ") + 2));
-        p.Max.clear();
-        while (ss >> val) p.Max.push_back(val);
-        getline(file, line);
-        ss.clear();
-        ss.str(line.substr(line.find(": ") + 2));
-        p.Allocation.clear();
-        while (ss >> val) p.Allocation.push_back(val);
-        getline(file, line);
-        ss.clear();
-        ss.str(line.substr(line.find(": ") + 2));
-        p.Need.clear();
-        while (ss >> val) p.Need.push_back(val);
-        getline(file, line);
-        p.status = (line.substr(line.find(": ") + 2) == "true");
-        getline(file, line);
-        p.priority = stoi(line.substr(line.find(": ") + 2));
-        getline(file, line);
-        p.cpu_usage = stod(line.substr(line.find(": ") + 2));
-        getline(file, line);
-        p.wait_time = stoi(line.substr(line.find(": ") + 2));
-        processes.push_back(p);
-        historical_need[p.id] = vector<vector<int>>();
-    }
-
-    history.clear();
+    int number = 0;
     while (getline(file, line)) {
-        AllocationHistory h;
-        h.pid = stoi(line.substr(line.find(": ") + 2));
-        getline(file, line);
-        ss.clear();
-        ss.str(line.substr(line.find(": ") + 2));
-        h.resources.clear();
-        while (ss >> val) h.resources.push_back(val);
-        getline(file, line);
-        h.timestamp = stoll(line.substr(line.find(": ") + 2));
-        getline(file, line);
-        h.action = line.substr(line.find(": ") + 2);
-        history.push_back(h);
+        number++;
+        stringstream ss(line);
+        string word;
+        if (!(ss >> word) || word[0] == '#') continue;
+
+        BatchCommand cmd;
+        cmd.line = number;
+        cmd.pid = 0;
+        cmd.priority = 0;
+        bool ok = true;
+        if (word == "request" || word == "release") {
+            cmd.op = word == "request" ? BatchOp::Request : BatchOp::Release;
+            ok = static_cast<bool>(ss >> cmd.pid);
+            int value;
+            while (ok && ss >> value) cmd.amounts.push_back(value);
+            ok = ok && !cmd.amounts.empty() && ss.eof();
+        } else if (word == "add") {
+            cmd.op = BatchOp::Add;
+            ok = static_cast<bool>(ss >> cmd.pid >> cmd.priority);
+        } else if (word == "remove") {
+            cmd.op = BatchOp::Remove;
+            ok = static_cast<bool>(ss >> cmd.pid);
+        } else if (word == "safe") {
+            cmd.op = BatchOp::Safe;
+        } else if (word == "detect") {
+            cmd.op = BatchOp::Detect;
+        } else if (word == "reset") {
+            cmd.op = BatchOp::Reset;
+        } else if (word == "load" || word == "export") {
+            cmd.op = word == "load" ? BatchOp::Load : BatchOp::Export;
+            ok = static_cast<bool>(ss >> cmd.path);
+        } else if (word == "save" || word == "restore") {
+            cmd.op = word == "save" ? BatchOp::Save : BatchOp::Restore;
+            ok = static_cast<bool>(ss >> cmd.path);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            error = filename + ":" + to_string(number) + ": cannot parse '" + line + "'";
+            return false;
+        }
+        commands.push_back(cmd);
     }
-
-    file.close();
-    cout << GREEN << "Configuration loaded from " << filename << RESET << endl;
-    LogAction("Config", "Loaded from " + filename);
+    return true;
 }
 
-void DisplaySimulationStats() {
-    cout << "\n" << BOLD << BLUE << "Simulation Statistics:" << RESET << endl;
-    cout << "Requests Processed: " << sim_stats.requests_processed << endl;
-    cout << "Deadlocks Detected: " << sim_stats.deadlocks_detected << endl;
-    cout << "Deadlocks Resolved: " << sim_stats.deadlocks_resolved << endl;
-    cout << "Average Response Time: " << fixed << setprecision(2) << sim_stats.avg_response_time << " μs" << endl;
-    cout << "Total Simulation Cycles: " << sim_stats.total_cycles << endl;
-    LogAction("Stats", "Displayed simulation statistics");
+const char* AdmissionOutcomeName(AdmissionOutcome outcome) {
+    switch (outcome) {
+        case AdmissionOutcome::Granted: return "granted";
+        case AdmissionOutcome::DeniedUnsafe: return "denied-unsafe";
+        case AdmissionOutcome::DeniedInsufficient: return "denied-insufficient";
+        case AdmissionOutcome::Invalid: return "invalid";
+    }
+    return "?";
 }
 
-void UpdatePriorityQueue() {
-    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> pq;
-    for (int i = 0; i < nprocesses; i++) {
-        if (!processes[i].status) {
-            pq.push({processes[i].priority, i});
+int RunBatchDriver(int argc, char** argv) {
+    string batch_path, results_path, replay_path;
+    bool timed = false;
+    const string usage = string("usage: ") + argv[0] +
+                         " [--batch commands.txt [--results results.txt] | --replay trace.bin [--timed]]";
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        if (arg == "--batch" && a + 1 < argc) {
+            batch_path = argv[++a];
+        } else if (arg == "--results" && a + 1 < argc) {
+            results_path = argv[++a];
+        } else if (arg == "--replay" && a + 1 < argc) {
+            replay_path = argv[++a];
+        } else if (arg == "--timed") {
+            timed = true;
+        } else {
+            cerr << usage << endl;
+            return 2;
         }
     }
-    cout << "\n" << BOLD << MAGENTA << "Priority Queue Updated:" << RESET << endl;
-    while (!pq.empty()) {
-        cout << "P" << pq.top().second << " (Priority: " << pq.top().first << ")" << endl;
-        pq.pop();
+    if (batch_path.empty() == replay_path.empty()) {
+        cerr << usage << endl;
+        return 2;
     }
-    LogAction("PriorityQueue", "Updated and displayed");
-}
 
-void ValidateInput(int pid, const vector<int>& vec, const string& type) {
-    if (pid < 0 || pid >= nprocesses) {
-        cout << RED << "Invalid process ID: " << pid << RESET << endl;
-        throw invalid_argument("Invalid process ID");
+    if (!replay_path.empty()) {
+        vector<TraceRecord> records;
+        string error;
+        if (!ReadTraceFile(replay_path, records, error)) {
+            cerr << error << endl;
+            return 1;
+        }
+        banker.Reset();
+        ReplayReport report = ReplayTrace(records, timed);
+        PrintReplayReport(report, replay_path);
+        return report.divergent == 0 && report.error.empty() ? 0 : 1;
     }
-    if (vec.size() != static_cast<size_t>(nresources)) {
-        cout << RED << "Invalid " << type << " size: expected " << nresources << RESET << endl;
-        throw invalid_argument("Invalid " + type + " size");
+
+    vector<BatchCommand> commands;
+    string error;
+    if (!ParseBatchFile(batch_path, commands, error)) {
+        cerr << error << endl;
+        return 1;
     }
-    for (int v : vec) {
-        if (v < 0) {
-            cout << RED << "Negative values not allowed in " << type << RESET << endl;
-            throw invalid_argument("Negative values in " + type);
+
+    banker.Reset();
+    // Per command: an AdmissionOutcome for requests, 1/0 for the others,
+    // the cycle length for detect, or the new pid for add
+    vector<int> results(commands.size(), 0);
+    int failures = 0;
+    auto start = chrono::steady_clock::now();
+    for (size_t k = 0; k < commands.size(); k++) {
+        const BatchCommand& cmd = commands[k];
+        switch (cmd.op) {
+            case BatchOp::Request:
+                results[k] = static_cast<int>(banker.Request(cmd.pid, cmd.amounts));
+                break;
+            case BatchOp::Release:
+                results[k] = banker.Release(cmd.pid, cmd.amounts);
+                break;
+            case BatchOp::Add:
+                results[k] = banker.AddProcess(cmd.pid, cmd.priority);
+                break;
+            case BatchOp::Remove:
+                results[k] = banker.RemoveProcess(cmd.pid);
+                break;
+            case BatchOp::Safe:
+                results[k] = banker.IsSafe();
+                break;
+            case BatchOp::Detect:
+                results[k] = static_cast<int>(banker.FindDeadlockCycle().size());
+                break;
+            case BatchOp::Reset:
+                banker.Reset();
+                results[k] = 1;
+                break;
+            case BatchOp::Load: {
+                string load_error;
+                results[k] = banker.LoadConfig(cmd.path, &load_error);
+                if (!results[k]) cerr << "load failed: " << load_error << endl;
+                break;
+            }
+            case BatchOp::Export:
+                results[k] = banker.ExportConfig(cmd.path);
+                break;
+            case BatchOp::Save:
+                results[k] = banker.SaveSnapshot(cmd.path);
+                break;
+            case BatchOp::Restore:
+                results[k] = banker.LoadSnapshot(cmd.path);
+                break;
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    map<string, int> tally;
+    ofstream results_file;
+    if (!results_path.empty()) results_file.open(results_path);
+    for (size_t k = 0; k < commands.size(); k++) {
+        const BatchCommand& cmd = commands[k];
+        string outcome;
+        switch (cmd.op) {
+            case BatchOp::Request:
+                outcome = string("request ") + AdmissionOutcomeName(static_cast<AdmissionOutcome>(results[k]));
+                break;
+            case BatchOp::Release:
+                outcome = results[k] ? "release ok" : "release rejected";
+                break;
+            case BatchOp::Add:
+                outcome = "add ok";
+                break;
+            case BatchOp::Remove:
+                outcome = results[k] ? "remove ok" : "remove rejected";
+                break;
+            case BatchOp::Safe:
+                outcome = results[k] ? "safe yes" : "safe no";
+                break;
+            case BatchOp::Detect:
+                outcome = results[k] ? "detect cycle" : "detect none";
+                break;
+            case BatchOp::Reset:
+                outcome = "reset ok";
+                break;
+            case BatchOp::Load:
+            case BatchOp::Export:
+                outcome = string(cmd.op == BatchOp::Load ? "load " : "export ") + (results[k] ? "ok" : "failed");
+                break;
+            case BatchOp::Save:
+            case BatchOp::Restore:
+                outcome = string(cmd.op == BatchOp::Save ? "save " : "restore ") + (results[k] ? "ok" : "failed");
+                break;
+        }
+        if (outcome.find("failed") != string::npos) failures++;
+        tally[outcome]++;
+        if (results_file.is_open()) {
+            results_file << cmd.line << " " << outcome;
+            if (cmd.op == BatchOp::Add) results_file << " P" << results[k];
+            results_file << "\n";
         }
     }
-}
 
-void InitializeSystem() {
-    processes.clear();
-    available.assign(nresources, 10);
-    total_resources = available;
-    nprocesses = 5;
-    processes.resize(nprocesses);
-    for (int i = 0; i < nprocesses; i++) {
-        processes[i].id = i;
-        processes[i].Max.assign(nresources, 5);
-        processes[i].Allocation.assign(nresources, 0);
-        processes[i].Need = processes[i].Max;
-        processes[i].status = false;
-        processes[i].priority = rand() % 5 + 1;
-        processes[i].cpu_usage = (rand() % 50 + 10) / 100.0;
-        processes[i].wait_time = 0;
-        historical_need[i] = vector<vector<int>>();
+    cout << "Replayed " << commands.size() << " commands from " << batch_path << " in " << fixed
+         << setprecision(3) << seconds * 1000 << " ms ("
+         << setprecision(0) << (seconds > 0 ? commands.size() / seconds : 0.0) << " commands/s)" << endl;
+    for (const auto& entry : tally) {
+        cout << "  " << left << setw(28) << entry.first << right << entry.second << endl;
     }
-    sim_stats = {0, 0, 0, 0.0, 0};
-    history.clear();
-    blockchain.clear();
-    InitializeBlockchain();
-    cout << GREEN << "System initialized with default configuration" << RESET << endl;
-    LogAction("Initialize", "System reset to default state");
+    return failures == 0 ? 0 : 1;
 }
 
 // ======================== Menu System ========================
@@ -906,12 +6448,30 @@ void DisplayMainMenu() {
     cout << "\n21. Detect Deadlock Cycle";
     cout << "\n22. Initialize System";
     cout << "\n23. Exit";
+    cout << "\n24. Batch Request Resources";
+    cout << "\n25. Configure Logging";
+    cout << "\n26. Full Chain Verification";
+    cout << "\n27. Configure Load Generator";
+    cout << "\n28. Start/Stop Trace Recording";
+    cout << "\n29. Replay Trace";
+    cout << "\n30. Configure History";
+    cout << "\n31. Configure Analytics";
+    cout << "\n32. Configure Deadlock Detection";
+    cout << "\n33. Configure Deadlock Recovery";
+    cout << "\n34. Save Binary Snapshot";
+    cout << "\n35. Load Binary Snapshot";
+    cout << "\n36. Configure Write-Ahead Log";
+    cout << "\n37. Configure Resource Partitions";
     cout << "\n\nEnter your choice: ";
 }
 
-int main() {
+#ifndef BANKER_BENCHMARK
+int main(int argc, char** argv) {
     srand(time(NULL));
+    logger.Start("system.log");
+    if (argc > 1) return RunBatchDriver(argc, argv);
     InitializeSystem();
+    OpenWriteAheadLog("banker");
 
     string choice;
     int option = 0;
@@ -923,7 +6483,8 @@ int main() {
             option = stoi(choice);
             switch (option) {
                 case 1: {
-                    if (IsSafe(processes, available)) {
+                    shared_lock<shared_mutex> lock(mtx);
+                    if (IsSafe()) {
                         cout << GREEN << "System is in safe state. Sequence: ";
                         for (int i = 0; i < seq.size(); i++) {
                             cout << "P" << seq[i];
@@ -961,7 +6522,22 @@ int main() {
                     cin >> max_res;
                     cout << "Enter priority (1-5): ";
                     cin >> priority;
-                    AddProcess(max_res, priority);
+                    vector<int> resources;
+                    int partition_count;
+                    {
+                        shared_lock<shared_mutex> lock(mtx);
+                        partition_count = partitions.Count();
+                    }
+                    if (partition_count > 0) {
+                        int partition;
+                        cout << "Enter partition (1-" << partition_count << ", 0 for all resource types): ";
+                        cin >> partition;
+                        shared_lock<shared_mutex> lock(mtx);
+                        if (partition > 0 && partition <= partitions.Count()) {
+                            resources = partitions.Resources(partition - 1);
+                        }
+                    }
+                    AddProcess(max_res, priority, resources);
                     break;
                 }
                 case 5: {
@@ -972,7 +6548,7 @@ int main() {
                     break;
                 }
                 case 6:
-                    DisplayAllocationTable(processes);
+                    DisplayAllocationTable(*state_views.Acquire(banker));
                     break;
                 case 7:
                     VisualizeResourceGraph();
@@ -1027,14 +6603,64 @@ int main() {
                     InitializeSystem();
                     break;
                 case 23:
+                    if (load_generator.Running()) StopSimulation();
+                    if (trace.Recording()) TraceMenu();
                     cout << "Exiting..." << endl;
                     break;
+                case 24:
+                    BatchRequestMenu();
+                    break;
+                case 25:
+                    ConfigureLogging();
+                    break;
+                case 26:
+                    FullChainVerification();
+                    break;
+                case 27:
+                    ConfigureLoadGenerator();
+                    break;
+                case 28:
+                    TraceMenu();
+                    break;
+                case 29:
+                    ReplayTraceMenu();
+                    break;
+                case 30:
+                    ConfigureHistory();
+                    break;
+                case 31:
+                    ConfigureAnalytics();
+                    break;
+                case 32:
+                    ConfigureDeadlockDetection();
+                    break;
+                case 33:
+                    ConfigureDeadlockRecovery();
+                    break;
+                case 34:
+                case 35: {
+                    string filename;
+                    cout << "Enter snapshot file name: ";
+                    cin >> filename;
+                    if (option == 34) {
+                        SaveStateToFile(filename);
+                    } else {
+                        LoadStateFromFile(filename);
+                    }
+                    break;
+                }
+                case 36:
+                    ConfigureWriteAheadLog();
+                    break;
+                case 37:
+                    ConfigurePartitions();
+                    break;
                 default:
                     cout << RED << "Invalid choice. Try again." << RESET << endl;
             }
         } catch (const exception& e) {
             cout << RED << "Error: " << e.what() << RESET << endl;
-            LogAction("Error", e.what());
+            LogMessage(LogLevel::Error, "Error", e.what());
         }
 
         if (option != 23) {
@@ -1046,18 +6672,9 @@ int main() {
 
     return 0;
 }
+#endif // BANKER_BENCHMARK
 
 // Placeholder implementations for unimplemented functions
-void SaveStateToFile(const string& filename) {
-    cout << YELLOW << "SaveStateToFile not implemented" << RESET << endl;
-    LogAction("SaveState", "Attempted to save state to " + filename);
-}
-
-void LoadStateFromFile(const string& filename) {
-    cout << YELLOW << "LoadStateFromFile not implemented" << RESET << endl;
-    LogAction("LoadState", "Attempted to load state from " + filename);
-}
-
 void NetworkSync() {
     cout << YELLOW << "NetworkSync not implemented" << RESET << endl;
     LogAction("NetworkSync", "Attempted network sync");
@@ -1065,83 +6682,85 @@ void NetworkSync() {
 
 void PerformanceMetrics() {
     cout << "\n" << BOLD << BLUE << "Performance Metrics:" << RESET << endl;
+    shared_ptr<const StateView> view = state_views.Acquire(banker);
+    const int n = view->nprocesses, m = view->nresources;
 
     auto start = chrono::high_resolution_clock::now();
-    bool safe = IsSafe(processes, available);
+    vector<int> sequence;
+    bool safe = safety_engine.Run(view->processes, view->need_matrix, view->allocation_matrix, view->available,
+                                  sequence);
     auto end = chrono::high_resolution_clock::now();
     auto duration = chrono::duration_cast<chrono::microseconds>(end - start);
 
     cout << "Safety check time: " << duration.count() << " μs" << endl;
     cout << "System state: " << (safe ? "Safe" : "Unsafe") << endl;
 
-    vector<double> utilization(nresources, 0.0);
-    for (int j = 0; j < nresources; j++) {
-        int allocated = 0;
-        for (int i = 0; i < nprocesses; i++) {
-            allocated += processes[i].Allocation[j];
-        }
-        utilization[j] = static_cast<double>(allocated) / (allocated + available[j]) * 100;
-        cout << "R" << j << " utilization: " << fixed << setprecision(2) << utilization[j] << "%" << endl;
-    }
-
+    vector<double> utilization(m, 0.0);
+    vector<int> allocated_totals = ColumnTotals(view->allocation_matrix, n);
     int deadlock_conditions = 0;
-    for (int i = 0; i < nprocesses; i++) {
-        for (int j = 0; j < nresources; j++) {
-            if (processes[i].Need[j] > available[j]) {
-                deadlock_conditions++;
-            }
-        }
+    for (int i = 0; i < n; i++) {
+        deadlock_conditions += row_kernels.count_greater(view->need_matrix.Row(i), view->available.data(), m);
+    }
+    for (int j = 0; j < m; j++) {
+        int allocated = allocated_totals[j];
+        utilization[j] = static_cast<double>(allocated) / (allocated + view->available[j]) * 100;
+        cout << "R" << j << " utilization: " << fixed << setprecision(2) << utilization[j] << "%" << endl;
     }
 
-    double deadlock_prob = min(1.0, static_cast<double>(deadlock_conditions) / (nprocesses * nresources) * 2);
+    double deadlock_prob = min(1.0, static_cast<double>(deadlock_conditions) / (n * m) * 2);
     cout << "Deadlock probability: " << deadlock_prob * 100 << "%" << endl;
+
+    LatencySummary admission = latency.Summarize(LatencyOp::Request);
+    cout << "Admission latency p99: " << admission.p99 / 1000.0 << " μs (" << admission.count << " requests)" << endl;
+    PrintLatencyTable();
     LogAction("Metrics", "Displayed performance metrics");
 }
 
 void GenerateSecurityReport() {
     cout << "\n" << BOLD << MAGENTA << "Security Audit Report:" << RESET << endl;
+    shared_ptr<const StateView> view = state_views.Acquire(banker);
 
     int warning_count = 0;
 
-    for (int i = 0; i < nprocesses; i++) {
-        for (int j = 0; j < nresources; j++) {
-            if (processes[i].Allocation[j] > processes[i].Max[j]) {
+    for (int i = 0; i < view->nprocesses; i++) {
+        const int* alloc = view->allocation_matrix.Row(i);
+        const int* max = view->max_matrix.Row(i);
+        for (int j = 0; j < view->nresources; j++) {
+            if (alloc[j] > max[j]) {
                 cout << RED << "SECURITY VIOLATION: P" << i << " allocated more than max for R" << j 
-                     << " (" << processes[i].Allocation[j] << " > " << processes[i].Max[j] << ")" << RESET << endl;
+                     << " (" << alloc[j] << " > " << max[j] << ")" << RESET << endl;
                 warning_count++;
             }
         }
     }
 
+    // The view was copied with no release half-way, so a mismatch between
+    // the totals and available is a real leak.
     int leaked_resources = 0;
-    for (int j = 0; j < nresources; j++) {
-        int total_alloc = 0;
-        for (int i = 0; i < nprocesses; i++) {
-            total_alloc += processes[i].Allocation[j];
-        }
+    vector<int> allocated_totals = ColumnTotals(view->allocation_matrix, view->nprocesses);
+    for (int j = 0; j < view->nresources; j++) {
+        int total_alloc = allocated_totals[j];
 
-        if (total_alloc + available[j] != total_resources[j]) {
+        if (total_alloc + view->available[j] != view->total_resources[j]) {
             cout << YELLOW << "RESOURCE LEAK: R" << j << " inconsistency ("
-                 << total_alloc + available[j] << " vs " << total_resources[j] << ")" << RESET << endl;
+                 << total_alloc + view->available[j] << " vs " << view->total_resources[j] << ")" << RESET << endl;
             leaked_resources++;
             warning_count++;
         }
     }
 
-    bool chain_valid = true;
-    for (size_t i = 1; i < blockchain.size(); i++) {
-        if (blockchain[i].previous_hash != blockchain[i-1].hash || 
-            blockchain[i].hash != CalculateHash(blockchain[i])) {
-            chain_valid = false;
-            break;
-        }
-    }
+    // Only blocks appended since the previous audit are re-hashed; use the
+    // full verification option to re-check the entire chain.
+    int checked = 0;
+    int length = ChainLength();
+    bool chain_valid = chain_verifier.VerifyNew(length, checked);
 
     if (!chain_valid) {
-        cout << RED << "BLOCKCHAIN TAMPERING DETECTED!" << RESET << endl;
+        cout << RED << "BLOCKCHAIN TAMPERING DETECTED at block #" << chain_verifier.VerifiedUpto() << "!" << RESET << endl;
         warning_count++;
     } else {
-        cout << GREEN << "Blockchain integrity verified (" << blockchain.size() << " blocks)" << RESET << endl;
+        cout << GREEN << "Blockchain integrity verified (" << length << " blocks, "
+             << checked << " newly checked)" << RESET << endl;
     }
 
     if (warning_count == 0) {
@@ -1152,13 +6771,44 @@ void GenerateSecurityReport() {
     LogAction("Security", "Generated security report");
 }
 
+void FullChainVerification() {
+    cout << "\n" << BOLD << MAGENTA << "Full Chain Verification:" << RESET << endl;
+    int threads = max(1u, thread::hardware_concurrency());
+    auto start = chrono::high_resolution_clock::now();
+    int first_bad = 0;
+    int length = ChainLength();
+    bool valid = chain_verifier.VerifyFull(length, threads, first_bad);
+    auto end = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::milliseconds>(end - start).count();
+
+    if (valid) {
+        cout << GREEN << "All " << length << " blocks verified on " << threads << " threads in "
+             << duration << " ms" << RESET << endl;
+        cout << "Checkpoints: " << chain_verifier.CheckpointCount() << ", root: "
+             << HashToHex(chain_verifier.Root()) << endl;
+    } else {
+        cout << RED << "BLOCKCHAIN TAMPERING DETECTED at block #" << first_bad << "!" << RESET << endl;
+    }
+    LogAction("Security", valid ? "Full chain verification passed"
+                                : "Full chain verification failed at block " + to_string(first_bad));
+}
+
 void DisplayBlockchain() {
-    cout << "\n" << BOLD << MAGENTA << "Blockchain Contents:" << RESET << endl;
-    for (const auto& block : blockchain) {
-        cout << "Block #" << block.index << " | " << ctime(&block.timestamp);
-        cout << "Transaction: " << block.transaction << endl;
-        cout << "Previous Hash: " << block.previous_hash << endl;
-        cout << "Hash: " << block.hash << endl << endl;
+    cout << "\n" << BOLD << MAGENTA << "Blockchain Contents (" << BLOCK_HASH_NAME << "):" << RESET << endl;
+    const int kPage = 4096;
+    vector<Block> page;
+    int length = ChainLength();
+    for (int start = 0; start < length; start += kPage) {
+        if (!LoadBlocks(start, min(kPage, length - start), page)) {
+            cout << RED << "Failed to read blocks from the ledger" << RESET << endl;
+            break;
+        }
+        for (const auto& block : page) {
+            cout << "Block #" << block.index << " | " << ctime(&block.timestamp);
+            cout << "Transaction: " << block.transaction << endl;
+            cout << "Previous Hash: " << HashToHex(block.previous_hash) << endl;
+            cout << "Hash: " << HashToHex(block.hash) << endl << endl;
+        }
     }
     LogAction("Blockchain", "Displayed blockchain contents");
 }
@@ -1187,3 +6837,249 @@ void CalculateDeadlockProbability() {
     cout << YELLOW << "CalculateDeadlockProbability not implemented" << RESET << endl;
     LogAction("DeadlockProb", "Attempted to calculate deadlock probability");
 }
+
+// ======================== Benchmark ========================
+// Built with -DBANKER_BENCHMARK in place of the interactive menu. Sweeps
+// process counts, resource counts and load factors (share of every resource
+// already allocated) over the core operations and writes one JSON object per
+// case, so runs can be diffed for regressions. Console output of the measured
+// functions is discarded and logging is limited to warnings.
+#ifdef BANKER_BENCHMARK
+
+struct BenchCase {
+    int processes;
+    int resources;
+    double load;
+};
+
+// Random state: every process wants 1-8 units of each resource, total units
+// are half of the summed maxima, and load * total units are handed out
+void SetupBenchState(const BenchCase& c, mt19937& rng) {
+    unique_lock<shared_mutex> lock(mtx);
+    nprocesses = c.processes;
+    nresources = c.resources;
+    processes.assign(nprocesses, process());
+    max_matrix.Reset(nprocesses, nresources);
+    allocation_matrix.Reset(nprocesses, nresources);
+    need_matrix.Reset(nprocesses, nresources);
+    request_matrix.Reset(nprocesses, nresources);
+    total_resources.assign(nresources, 0);
+    for (int i = 0; i < nprocesses; i++) {
+        processes[i].id = i;
+        processes[i].status = false;
+        processes[i].priority = 1 + static_cast<int>(rng() % 5);
+        processes[i].cpu_usage = 0.0;
+        processes[i].wait_time = 0;
+        for (int j = 0; j < nresources; j++) {
+            max_matrix(i, j) = 1 + static_cast<int>(rng() % 8);
+            total_resources[j] += max_matrix(i, j);
+        }
+    }
+    available.assign(nresources, 0);
+    for (int j = 0; j < nresources; j++) {
+        total_resources[j] = max(1, total_resources[j] / 2);
+        int to_allocate = static_cast<int>(c.load * total_resources[j]);
+        for (int tries = 0; to_allocate > 0 && tries < 64 * nprocesses; tries++) {
+            int i = static_cast<int>(rng() % nprocesses);
+            if (allocation_matrix(i, j) < max_matrix(i, j)) {
+                allocation_matrix(i, j)++;
+                to_allocate--;
+            }
+        }
+        int allocated = 0;
+        for (int i = 0; i < nprocesses; i++) allocated += allocation_matrix(i, j);
+        available[j] = total_resources[j] - allocated;
+    }
+    for (int i = 0; i < nprocesses; i++) {
+        for (int j = 0; j < nresources; j++) need_matrix(i, j) = max_matrix(i, j) - allocation_matrix(i, j);
+    }
+    wait_for_graph.Reset(nprocesses, nresources);
+    state_views.Reset(nprocesses);
+    partitions.Rebuild(processes, max_matrix, allocation_matrix, need_matrix);
+    lock_guard<mutex> history_lock(history_mtx);
+    history.Reset(nresources);
+    historical_need.Reset(nresources);
+    history_stats.Reset(nresources);
+}
+
+class BenchReporter {
+public:
+    explicit BenchReporter(ostream& out) : out_(out) {}
+
+    void Report(const string& name, const BenchCase& c, const LatencyHistogram& h, double seconds) {
+        LatencySummary s = h.Summarize();
+        out_ << "{\"bench\":\"" << name << "\",\"processes\":" << c.processes << ",\"resources\":" << c.resources
+             << ",\"load\":" << fixed << setprecision(2) << c.load << ",\"ops\":" << s.count
+             << ",\"seconds\":" << setprecision(4) << seconds
+             << ",\"ops_per_sec\":" << setprecision(1) << (seconds > 0 ? s.count / seconds : 0.0)
+             << ",\"mean_ns\":" << s.mean_ns << ",\"p50_ns\":" << s.p50 << ",\"p90_ns\":" << s.p90
+             << ",\"p99_ns\":" << s.p99 << ",\"p999_ns\":" << s.p999 << ",\"max_ns\":" << s.max << "}" << endl;
+    }
+
+private:
+    ostream& out_;
+};
+
+// Run op until budget_s has passed or max_ops calls were made, timing each call
+template <typename F>
+double TimeOps(LatencyHistogram& h, double budget_s, int max_ops, F op) {
+    auto begin = chrono::steady_clock::now();
+    auto deadline = begin + chrono::duration<double>(budget_s);
+    for (int n = 0; n < max_ops; n++) {
+        auto start = chrono::steady_clock::now();
+        op();
+        auto end = chrono::steady_clock::now();
+        h.Record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(end - start).count()));
+        if (end >= deadline) break;
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+}
+
+int RunBenchmarks(int argc, char** argv) {
+    bool quick = false;
+    string out_path;
+    for (int a = 1; a < argc; a++) {
+        string arg = argv[a];
+        if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--out" && a + 1 < argc) {
+            out_path = argv[++a];
+        } else {
+            cerr << "usage: " << argv[0] << " [--quick] [--out results.jsonl]" << endl;
+            return 2;
+        }
+    }
+
+    streambuf* console = cout.rdbuf();
+    ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path);
+        if (!file.is_open()) {
+            cerr << "cannot open " << out_path << endl;
+            return 1;
+        }
+    }
+    ostream results(out_path.empty() ? console : file.rdbuf());
+    BenchReporter reporter(results);
+    cout.rdbuf(nullptr); // the measured functions print; drop it
+
+    logger.SetLevel(LogLevel::Warn);
+    InitializeBlockchain();
+
+    vector<int> process_counts = quick ? vector<int>{16, 128} : vector<int>{16, 64, 256, 1024};
+    vector<int> resource_counts = quick ? vector<int>{4, 16} : vector<int>{4, 16, 64};
+    vector<double> loads = quick ? vector<double>{0.5, 0.9} : vector<double>{0.25, 0.5, 0.75, 0.9};
+    const double budget = quick ? 0.05 : 0.25;
+    const int max_ops = 1000000;
+    const string state_file = "benchmark_state.txt";
+    const string snapshot_file = "benchmark_state.bin";
+    mt19937 rng(12345);
+
+    for (int P : process_counts) {
+        for (int R : resource_counts) {
+            for (double load : loads) {
+                BenchCase c = {P, R, load};
+
+                SetupBenchState(c, rng);
+                {
+                    LatencyHistogram h;
+                    double seconds = TimeOps(h, budget, max_ops, [] {
+                        shared_lock<shared_mutex> lock(mtx);
+                        IsSafe();
+                    });
+                    reporter.Report("IsSafe", c, h, seconds);
+                }
+
+                // One unit of one resource per request; granted units are
+                // released again so the state does not drift.
+                {
+                    LatencyHistogram request_h, release_h;
+                    vector<int> amounts(R, 0);
+                    auto begin = chrono::steady_clock::now();
+                    auto deadline = begin + chrono::duration<double>(budget);
+                    double release_seconds = 0;
+                    for (int n = 0; n < max_ops && chrono::steady_clock::now() < deadline; n++) {
+                        int pid = static_cast<int>(rng() % P);
+                        int j = static_cast<int>(rng() % R);
+                        fill(amounts.begin(), amounts.end(), 0);
+                        amounts[j] = 1;
+                        auto t0 = chrono::steady_clock::now();
+                        AdmissionOutcome outcome = TryRequest(pid, amounts);
+                        auto t1 = chrono::steady_clock::now();
+                        request_h.Record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(t1 - t0).count()));
+                        if (outcome == AdmissionOutcome::Granted) {
+                            TryRelease(pid, amounts);
+                            auto t2 = chrono::steady_clock::now();
+                            release_h.Record(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count()));
+                            release_seconds += chrono::duration<double>(t2 - t1).count();
+                        }
+                    }
+                    double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+                    reporter.Report("RequestResources", c, request_h, seconds - release_seconds);
+                    reporter.Report("ReleaseResources", c, release_h, release_seconds);
+                    lock_guard<mutex> history_lock(history_mtx);
+                    history.clear();
+                }
+
+                {
+                    LatencyHistogram h;
+                    double seconds = TimeOps(h, budget, max_ops, [] { FindDeadlockCycle(); });
+                    reporter.Report("DetectDeadlockCycle", c, h, seconds);
+                }
+
+                // The hashing and chain benchmarks do not depend on the load factor
+                if (load == loads.front() && R == resource_counts.front()) {
+                    Block block;
+                    block.index = P;
+                    block.timestamp = time(nullptr);
+                    block.transaction = "P" + to_string(P) + " allocated resources";
+                    block.previous_hash = 0;
+                    LatencyHistogram hash_h;
+                    volatile uint64_t sink = 0;
+                    double seconds = TimeOps(hash_h, budget, max_ops, [&] {
+                        block.index++;
+                        sink = sink ^ CalculateHash(block);
+                    });
+                    reporter.Report("CalculateHash", c, hash_h, seconds);
+
+                    InitializeBlockchain();
+                    LatencyHistogram add_h;
+                    seconds = TimeOps(add_h, budget, max_ops, [] { AddBlock("P0 allocated resources"); });
+                    reporter.Report("AddBlock", c, add_h, seconds);
+                }
+
+                TryExportToText(state_file);
+                {
+                    LatencyHistogram h;
+                    double seconds = TimeOps(h, budget, quick ? 200 : 2000,
+                                             [&] { TryLoadConfigFromText(state_file); });
+                    reporter.Report("LoadConfigFromText", c, h, seconds);
+                }
+
+                // Starts from a fresh chain so the case measures the allocation state
+                InitializeBlockchain();
+                string error;
+                TrySaveSnapshot(snapshot_file, error);
+                {
+                    LatencyHistogram h;
+                    double seconds = TimeOps(h, budget, quick ? 200 : 2000,
+                                             [&] { TryLoadSnapshot(snapshot_file, error); });
+                    reporter.Report("LoadStateFromFile", c, h, seconds);
+                }
+            }
+        }
+    }
+
+    cout.rdbuf(console);
+    cout.clear();
+    ledger.Close();
+    remove(state_file.c_str());
+    remove(snapshot_file.c_str());
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    return RunBenchmarks(argc, argv);
+}
+
+#endif // BANKER_BENCHMARK